@@ -2,6 +2,16 @@
 
 #include "Walnut/UI/UI.h"
 #include "Walnut/Core/Log.h"
+#include "Walnut/Core/Profiler.h"
+#include "Walnut/Core/AllocationTracker.h"
+#include "Walnut/ImageCache.h"
+#include "Walnut/Vulkan/DeletionQueue.h"
+#include "Walnut/Vulkan/GPUTimeline.h"
+#include "Walnut/Vulkan/MemoryAllocator.h"
+#include "Walnut/Vulkan/OffscreenTarget.h"
+#include "Walnut/Vulkan/PipelineCache.h"
+#include "Walnut/Vulkan/SamplerCache.h"
+#include "Walnut/Vulkan/UploadQueue.h"
 
 //
 // Adapted from Dear ImGui Vulkan example
@@ -21,10 +31,13 @@
 #include <glm/glm.hpp>
 
 #include "ImGui/ImGuiTheme.h"
+#include "ImGui/FontCache.h"
 
 #include "stb_image.h"
 
+#include <format>
 #include <iostream>
+#include <unordered_map>
 
 // Emedded font
 #include "ImGui/Roboto-Regular.embed"
@@ -52,7 +65,6 @@ static VkDevice                 g_Device = VK_NULL_HANDLE;
 static uint32_t                 g_QueueFamily = (uint32_t)-1;
 static VkQueue                  g_Queue = VK_NULL_HANDLE;
 static VkDebugReportCallbackEXT g_DebugReport = VK_NULL_HANDLE;
-static VkPipelineCache          g_PipelineCache = VK_NULL_HANDLE;
 static VkDescriptorPool         g_DescriptorPool = VK_NULL_HANDLE;
 
 static ImGui_ImplVulkanH_Window g_MainWindowData;
@@ -61,17 +73,20 @@ static bool                     g_SwapChainRebuild = false;
 
 // Per-frame-in-flight
 static std::vector<std::vector<VkCommandBuffer>> s_AllocatedCommandBuffers;
-static std::vector<std::vector<std::function<void()>>> s_ResourceFreeQueue;
 
 static VkCommandBuffer s_ActiveCommandBuffer = nullptr;
 
-// Unlike g_MainWindowData.FrameIndex, this is not the the swapchain image index
-// and is always guaranteed to increase (eg. 0, 1, 2, 0, 1, 2)
-static uint32_t s_CurrentFrameIndex = 0;
-
 static std::unordered_map<std::string, ImFont*> s_Fonts;
 
-static Walnut::Application* s_Instance = nullptr;
+static std::unique_ptr<Walnut::UploadQueue> s_UploadQueue;
+
+// Replaces the swapchain with ApplicationSpecification::Offscreen
+static std::unique_ptr<Walnut::OffscreenTarget> s_OffscreenTarget;
+
+// Time FrameRender spent waiting for the frame's fence, which isn't CPU time of the frame
+static int64_t s_FenceWaitTime = 0;
+
+static std::atomic<Walnut::Application*> s_Instance = nullptr;
 
 void check_vk_result(VkResult err)
 {
@@ -91,14 +106,21 @@ static VKAPI_ATTR VkBool32 VKAPI_CALL debug_report(VkDebugReportFlagsEXT flags,
 }
 #endif // IMGUI_VULKAN_DEBUG_REPORT
 
-static void SetupVulkan(const char** extensions, uint32_t extensions_count)
+static void SetupVulkan(const char** extensions, uint32_t extensions_count, bool swapchain)
 {
 	VkResult err;
 
 	// Create Vulkan Instance
 	{
+		// Vulkan 1.2 for timeline semaphores (GPUTimeline)
+		VkApplicationInfo app_info = {};
+		app_info.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+		app_info.pEngineName = "Walnut";
+		app_info.apiVersion = VK_API_VERSION_1_2;
+
 		VkInstanceCreateInfo create_info = {};
 		create_info.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+		create_info.pApplicationInfo = &app_info;
 		create_info.enabledExtensionCount = extensions_count;
 		create_info.ppEnabledExtensionNames = extensions;
 #ifdef IMGUI_VULKAN_DEBUG_REPORT
@@ -187,7 +209,8 @@ static void SetupVulkan(const char** extensions, uint32_t extensions_count)
 
 	// Create Logical Device (with 1 queue)
 	{
-		int device_extension_count = 1;
+		// No swapchain when rendering offscreen, software implementations may not have one
+		int device_extension_count = swapchain ? 1 : 0;
 		const char* device_extensions[] = { "VK_KHR_swapchain" };
 		const float queue_priority[] = { 1.0f };
 		VkDeviceQueueCreateInfo queue_info[1] = {};
@@ -195,8 +218,19 @@ static void SetupVulkan(const char** extensions, uint32_t extensions_count)
 		queue_info[0].queueFamilyIndex = g_QueueFamily;
 		queue_info[0].queueCount = 1;
 		queue_info[0].pQueuePriorities = queue_priority;
+		VkPhysicalDeviceTimelineSemaphoreFeatures timeline_features = {};
+		timeline_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+		{
+			VkPhysicalDeviceFeatures2 features = {};
+			features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+			features.pNext = &timeline_features;
+			vkGetPhysicalDeviceFeatures2(g_PhysicalDevice, &features);
+			IM_ASSERT(timeline_features.timelineSemaphore);
+		}
+
 		VkDeviceCreateInfo create_info = {};
 		create_info.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+		create_info.pNext = &timeline_features;
 		create_info.queueCreateInfoCount = sizeof(queue_info) / sizeof(queue_info[0]);
 		create_info.pQueueCreateInfos = queue_info;
 		create_info.enabledExtensionCount = device_extension_count;
@@ -288,38 +322,50 @@ static void CleanupVulkanWindow()
 
 static void FrameRender(Walnut::Application* application, ImGui_ImplVulkanH_Window* wd, ImDrawData* draw_data)
 {
+	WL_PROFILE_FUNC();
+
 	VkResult err;
 
-	VkSemaphore image_acquired_semaphore = wd->FrameSemaphores[wd->SemaphoreIndex].ImageAcquiredSemaphore;
-	VkSemaphore render_complete_semaphore = wd->FrameSemaphores[wd->SemaphoreIndex].RenderCompleteSemaphore;
-	err = vkAcquireNextImageKHR(g_Device, wd->Swapchain, UINT64_MAX, image_acquired_semaphore, VK_NULL_HANDLE, &wd->FrameIndex);
-	if (err == VK_ERROR_OUT_OF_DATE_KHR || err == VK_SUBOPTIMAL_KHR)
+	VkSemaphore image_acquired_semaphore = VK_NULL_HANDLE;
+	VkSemaphore render_complete_semaphore = VK_NULL_HANDLE;
+	if (s_OffscreenTarget)
 	{
-		g_SwapChainRebuild = true;
-		return;
+		// No swapchain, the offscreen images are used in turn
+		wd->FrameIndex = (wd->FrameIndex + 1) % wd->ImageCount;
+	}
+	else
+	{
+		image_acquired_semaphore = wd->FrameSemaphores[wd->SemaphoreIndex].ImageAcquiredSemaphore;
+		render_complete_semaphore = wd->FrameSemaphores[wd->SemaphoreIndex].RenderCompleteSemaphore;
+		err = vkAcquireNextImageKHR(g_Device, wd->Swapchain, UINT64_MAX, image_acquired_semaphore, VK_NULL_HANDLE, &wd->FrameIndex);
+		if (err == VK_ERROR_OUT_OF_DATE_KHR || err == VK_SUBOPTIMAL_KHR)
+		{
+			g_SwapChainRebuild = true;
+			return;
+		}
+		check_vk_result(err);
 	}
-	check_vk_result(err);
-
-	s_CurrentFrameIndex = (s_CurrentFrameIndex + 1) % g_MainWindowData.ImageCount;
 
 	ImGui_ImplVulkanH_Frame* fd = &wd->Frames[wd->FrameIndex];
 	{
+		const int64_t fence_wait_start = Walnut::Clock::Now();
 		err = vkWaitForFences(g_Device, 1, &fd->Fence, VK_TRUE, UINT64_MAX);    // wait indefinitely instead of periodically checking
 		check_vk_result(err);
+		s_FenceWaitTime = Walnut::Clock::Now() - fence_wait_start;
 
 		err = vkResetFences(g_Device, 1, &fd->Fence);
 		check_vk_result(err);
 	}
+
+	// Timings and captures of the last frame rendered into this image
+	if (s_OffscreenTarget)
+		s_OffscreenTarget->CollectFrame(wd->FrameIndex);
 	
-	{
-		// Free resources in queue
-		for (auto& func : s_ResourceFreeQueue[s_CurrentFrameIndex])
-			func();
-		s_ResourceFreeQueue[s_CurrentFrameIndex].clear();
-	}
+	// Destroy released resources the GPU is done with
+	Walnut::DeletionQueue::Collect();
 	{
 		// Free command buffers allocated by Application::GetCommandBuffer
-		// These use g_MainWindowData.FrameIndex and not s_CurrentFrameIndex because they're tied to the swapchain image index
+		// These are tied to the swapchain image index (g_MainWindowData.FrameIndex)
 		auto& allocatedCommandBuffers = s_AllocatedCommandBuffers[wd->FrameIndex];
 		if (allocatedCommandBuffers.size() > 0)
 		{
@@ -336,6 +382,13 @@ static void FrameRender(Walnut::Application* application, ImGui_ImplVulkanH_Wind
 		s_ActiveCommandBuffer = fd->CommandBuffer;
 		check_vk_result(err);
 	}
+	if (s_OffscreenTarget)
+		s_OffscreenTarget->BeginFrame(wd->FrameIndex, fd->CommandBuffer);
+	{
+		// Texture uploads queued since the last frame
+		WL_PROFILE_SCOPE("UploadQueue::Record");
+		s_UploadQueue->Record(fd->CommandBuffer, Walnut::GPUTimeline::GetPendingValue());
+	}
 	{
 		VkRenderPassBeginInfo info = {};
 		info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
@@ -356,17 +409,33 @@ static void FrameRender(Walnut::Application* application, ImGui_ImplVulkanH_Wind
 
 	// Submit command buffer
 	vkCmdEndRenderPass(fd->CommandBuffer);
+	if (s_OffscreenTarget)
+		s_OffscreenTarget->EndFrame(wd->FrameIndex, fd->CommandBuffer);
 	{
+		// Also signals the next GPUTimeline value, the binary semaphore ignores its value
+		const uint64_t timeline_value = Walnut::GPUTimeline::BeginSubmission();
+		VkSemaphore signal_semaphores[] = { render_complete_semaphore, Walnut::GPUTimeline::GetSemaphore() };
+		const uint64_t signal_values[] = { 0, timeline_value };
+
+		// Offscreen frames have no swapchain semaphores and only signal the timeline
+		const uint32_t first_signal = s_OffscreenTarget ? 1 : 0;
+
+		VkTimelineSemaphoreSubmitInfo timeline_info = {};
+		timeline_info.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+		timeline_info.signalSemaphoreValueCount = 2 - first_signal;
+		timeline_info.pSignalSemaphoreValues = signal_values + first_signal;
+
 		VkPipelineStageFlags wait_stage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
 		VkSubmitInfo info = {};
 		info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-		info.waitSemaphoreCount = 1;
+		info.pNext = &timeline_info;
+		info.waitSemaphoreCount = s_OffscreenTarget ? 0 : 1;
 		info.pWaitSemaphores = &image_acquired_semaphore;
 		info.pWaitDstStageMask = &wait_stage;
 		info.commandBufferCount = 1;
 		info.pCommandBuffers = &fd->CommandBuffer;
-		info.signalSemaphoreCount = 1;
-		info.pSignalSemaphores = &render_complete_semaphore;
+		info.signalSemaphoreCount = 2 - first_signal;
+		info.pSignalSemaphores = signal_semaphores + first_signal;
 
 		err = vkEndCommandBuffer(fd->CommandBuffer);
 		s_ActiveCommandBuffer = nullptr;
@@ -378,6 +447,8 @@ static void FrameRender(Walnut::Application* application, ImGui_ImplVulkanH_Wind
 
 static void FramePresent(ImGui_ImplVulkanH_Window* wd)
 {
+	WL_PROFILE_FUNC();
+
 	if (g_SwapChainRebuild)
 		return;
 	VkSemaphore render_complete_semaphore = wd->FrameSemaphores[wd->SemaphoreIndex].RenderCompleteSemaphore;
@@ -398,6 +469,29 @@ static void FramePresent(ImGui_ImplVulkanH_Window* wd)
 	wd->SemaphoreIndex = (wd->SemaphoreIndex + 1) % wd->ImageCount; // Now we can use the next set of semaphores
 }
 
+// Per-user cache directory of the platform, caches can be deleted at any time
+static std::filesystem::path GetDefaultCacheDirectory(const std::string& appName)
+{
+#ifdef _WIN32
+	const char* appdata = std::getenv("LOCALAPPDATA");
+	if (appdata)
+		return std::filesystem::path(appdata) / appName / "cache";
+#elif __APPLE__
+	const char* home = std::getenv("HOME");
+	if (home)
+		return std::filesystem::path(home) / "Library" / "Caches" / appName;
+#elif __linux__
+	const char* xdg_cache = std::getenv("XDG_CACHE_HOME");
+	if (xdg_cache)
+		return std::filesystem::path(xdg_cache) / appName;
+
+	const char* home = std::getenv("HOME");
+	if (home)
+		return std::filesystem::path(home) / ".cache" / appName;
+#endif
+	return "cache";
+}
+
 static void glfw_error_callback(int error, const char* description)
 {
 	fprintf(stderr, "Glfw Error %d: %s\n", error, description);
@@ -408,6 +502,88 @@ namespace Walnut {
 #include "Walnut/Embed/Walnut-Icon.embed"
 #include "Walnut/Embed/WindowImages.embed"
 
+	// What a soft restart hands from one application to the next (see Application::Restart),
+	// everything else that survives lives in the file statics
+	struct RetainedState
+	{
+		int64_t RestartStart = 0;
+
+		GLFWwindow* WindowHandle = nullptr;
+		std::shared_ptr<Image> AppHeaderIcon;
+		std::unique_ptr<ImageAtlas> Atlas;
+		AtlasImage IconClose;
+		AtlasImage IconMinimize;
+		AtlasImage IconMaximize;
+		AtlasImage IconRestore;
+	};
+
+	// Set between the Shutdown of a restarting application and the Init of the next one
+	static std::unique_ptr<RetainedState> s_RetainedState;
+
+	// Times one Init phase for the startup report, and shows it in the profiler
+	class StartupPhaseScope
+	{
+	public:
+		StartupPhaseScope(std::vector<StartupPhase>& phases, const char* name)
+			: m_Phases(phases), m_Name(name), m_ProfileScope(name), m_Start(Clock::Now())
+		{
+		}
+
+		~StartupPhaseScope()
+		{
+			m_Phases.push_back({ m_Name, Clock::Now() - m_Start });
+		}
+
+		StartupPhaseScope(const StartupPhaseScope&) = delete;
+		StartupPhaseScope& operator=(const StartupPhaseScope&) = delete;
+	private:
+		std::vector<StartupPhase>& m_Phases;
+		const char* m_Name;
+		ProfileScope m_ProfileScope;
+		int64_t m_Start;
+	};
+
+	// RGBA pixels decoded on a worker, owned by whoever holds the last reference
+	struct DecodedImage
+	{
+		void* Data = nullptr;
+		uint32_t Width = 0;
+		uint32_t Height = 0;
+
+		~DecodedImage() { free(Data); }
+	};
+
+	struct PendingImage
+	{
+		std::shared_ptr<DecodedImage> Image;
+		JobHandle Job;
+	};
+
+	static PendingImage DecodeImageAsync(JobSystem& jobSystem, const uint8_t* buffer, uint64_t length)
+	{
+		PendingImage pending;
+		pending.Image = std::make_shared<DecodedImage>();
+		pending.Job = jobSystem.Submit([decoded = pending.Image, buffer, length]()
+		{
+			decoded->Data = Image::Decode(buffer, length, decoded->Width, decoded->Height);
+		});
+		return pending;
+	}
+
+	static PendingImage LoadImageAsync(JobSystem& jobSystem, const std::filesystem::path& filepath)
+	{
+		PendingImage pending;
+		pending.Image = std::make_shared<DecodedImage>();
+		pending.Job = jobSystem.Submit([decoded = pending.Image, filepath = filepath.string()]()
+		{
+			int width, height, channels;
+			decoded->Data = stbi_load(filepath.c_str(), &width, &height, &channels, 4);
+			decoded->Width = decoded->Data ? (uint32_t)width : 0;
+			decoded->Height = decoded->Data ? (uint32_t)height : 0;
+		});
+		return pending;
+	}
+
 	Application::Application(const ApplicationSpecification& specification)
 		: m_Specification(specification)
 	{
@@ -428,267 +604,383 @@ namespace Walnut {
 		return *s_Instance;
 	}
 
+	Application* Application::TryGet()
+	{
+		return s_Instance.load(std::memory_order_acquire);
+	}
+
 	void Application::Init()
 	{
-		// Intialize logging
-		Log::Init(m_Specification.Name);
+		// Loggers, window, device and ImGui are still up after a soft restart
+		const bool restart = (bool)s_RetainedState;
 
-		// Setup GLFW window
-		glfwSetErrorCallback(glfw_error_callback);
-		if (!glfwInit())
+		if (!restart)
 		{
-			std::cerr << "Could not initalize GLFW!\n";
-			return;
+			StartupPhaseScope phase(m_StartupPhases, "Logging");
+
+			// Intialize logging
+			Log::Init(m_Specification.Name, m_Specification.LogRingBufferSize);
 		}
 
-		glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+		WL_PROFILE_THREAD("Main");
 
-		if (m_Specification.CustomTitlebar)
 		{
-			glfwWindowHint(GLFW_TITLEBAR, false);
+			StartupPhaseScope phase(m_StartupPhases, "Job system");
 
-			// NOTE(Yan): Undecorated windows are probably
-			//            also desired, so make this an option
-			//glfwWindowHint(GLFW_DECORATED, false);
+			m_JobSystem = std::make_unique<JobSystem>(m_Specification.WorkerThreadCount);
+
+			m_MainThreadID = std::this_thread::get_id();
+			m_JobSystem->SetMainThreadWakeCallback([this]() { WakeMainLoop(); });
 		}
 
-		GLFWmonitor* primaryMonitor = glfwGetPrimaryMonitor();
-		const GLFWvidmode* videoMode = glfwGetVideoMode(primaryMonitor);
+		m_CacheDirectory = m_Specification.CacheDirectory.empty() ? GetDefaultCacheDirectory(m_Specification.Name) : m_Specification.CacheDirectory;
 
-		int monitorX, monitorY;
-		glfwGetMonitorPos(primaryMonitor, &monitorX, &monitorY);
+		if (restart)
+		{
+			m_WindowHandle = s_RetainedState->WindowHandle;
+			m_AppHeaderIcon = std::move(s_RetainedState->AppHeaderIcon);
+			m_ImageAtlas = std::move(s_RetainedState->Atlas);
+			m_IconClose = s_RetainedState->IconClose;
+			m_IconMinimize = s_RetainedState->IconMinimize;
+			m_IconMaximize = s_RetainedState->IconMaximize;
+			m_IconRestore = s_RetainedState->IconRestore;
+
+			if (m_WindowHandle)
+			{
+				glfwSetWindowUserPointer(m_WindowHandle, this);
+				glfwSetWindowTitle(m_WindowHandle, m_Specification.Name.c_str());
+			}
 
-		glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+			// OffscreenFrameCount and the frame time summary are per application
+			if (s_OffscreenTarget)
+				s_OffscreenTarget->ResetFrameCount();
 
-		m_WindowHandle = glfwCreateWindow(m_Specification.Width, m_Specification.Height, m_Specification.Name.c_str(), NULL, NULL);
+			// Nothing else would trigger the first frame of the new layers with EventDrivenRedraw
+			RequestRedraw();
 
-		if(videoMode->width < m_Specification.Width)
-		{
-			m_Specification.Width = videoMode->width;
+			WL_CORE_INFO_TAG("Application", "Restarted in {:.1f} ms", Clock::ToMilliseconds(Clock::Now() - s_RetainedState->RestartStart));
+			s_RetainedState.reset();
+			return;
 		}
 
-		if(videoMode->height < m_Specification.Height)
-		{
-			m_Specification.Height = videoMode->height;
-		}
+		// Work that doesn't need the window or the device runs on workers while they are created
+		PendingImage windowIcon;
+		if (!m_Specification.Offscreen && !m_Specification.IconPath.empty())
+			windowIcon = LoadImageAsync(*m_JobSystem, m_Specification.IconPath);
+
+		PendingImage appHeaderIcon = DecodeImageAsync(*m_JobSystem, g_WalnutIcon, sizeof(g_WalnutIcon));
+		PendingImage minimizeIcon = DecodeImageAsync(*m_JobSystem, g_WindowMinimizeIcon, sizeof(g_WindowMinimizeIcon));
+		PendingImage maximizeIcon = DecodeImageAsync(*m_JobSystem, g_WindowMaximizeIcon, sizeof(g_WindowMaximizeIcon));
+		PendingImage restoreIcon = DecodeImageAsync(*m_JobSystem, g_WindowRestoreIcon, sizeof(g_WindowRestoreIcon));
+		PendingImage closeIcon = DecodeImageAsync(*m_JobSystem, g_WindowCloseIcon, sizeof(g_WindowCloseIcon));
 
-		if (m_Specification.CenterWindow)
+		const std::filesystem::path fontCachePath = m_Specification.PersistentFontCache ? m_CacheDirectory / "fonts.bin" : std::filesystem::path();
+		JobHandle fontCacheJob;
+		if (!fontCachePath.empty())
+			fontCacheJob = m_JobSystem->Submit([fontCachePath]() { UI::FontCache::Preload(fontCachePath); });
+
+		// Offscreen rendering has no window at all
+		if (!m_Specification.Offscreen)
 		{
-			glfwSetWindowPos(m_WindowHandle,
-				monitorX + (videoMode->width - m_Specification.Width) / 2,
-				monitorY + (videoMode->height - m_Specification.Height) / 2);
+			StartupPhaseScope phase(m_StartupPhases, "Window");
 
-			glfwSetWindowAttrib(m_WindowHandle, GLFW_RESIZABLE, m_Specification.WindowResizeable ? GLFW_TRUE : GLFW_FALSE);
-		}
+			// Setup GLFW window
+			glfwSetErrorCallback(glfw_error_callback);
+			if (!glfwInit())
+			{
+				std::cerr << "Could not initalize GLFW!\n";
+				return;
+			}
+
+			glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+
+			if (m_Specification.CustomTitlebar)
+			{
+				glfwWindowHint(GLFW_TITLEBAR, false);
+
+				// NOTE(Yan): Undecorated windows are probably
+				//            also desired, so make this an option
+				//glfwWindowHint(GLFW_DECORATED, false);
+			}
+
+			GLFWmonitor* primaryMonitor = glfwGetPrimaryMonitor();
+			const GLFWvidmode* videoMode = glfwGetVideoMode(primaryMonitor);
+
+			int monitorX, monitorY;
+			glfwGetMonitorPos(primaryMonitor, &monitorX, &monitorY);
+
+			glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+			m_WindowHandle = glfwCreateWindow(m_Specification.Width, m_Specification.Height, m_Specification.Name.c_str(), NULL, NULL);
+
+			if(videoMode->width < m_Specification.Width)
+			{
+				m_Specification.Width = videoMode->width;
+			}
+
+			if(videoMode->height < m_Specification.Height)
+			{
+				m_Specification.Height = videoMode->height;
+			}
+
+			if (m_Specification.CenterWindow)
+			{
+				glfwSetWindowPos(m_WindowHandle,
+					monitorX + (videoMode->width - m_Specification.Width) / 2,
+					monitorY + (videoMode->height - m_Specification.Height) / 2);
+
+				glfwSetWindowAttrib(m_WindowHandle, GLFW_RESIZABLE, m_Specification.WindowResizeable ? GLFW_TRUE : GLFW_FALSE);
+			}
 		
-		glfwShowWindow(m_WindowHandle);
+			glfwShowWindow(m_WindowHandle);
 
-		// Setup Vulkan
-		if (!glfwVulkanSupported())
-		{
-			std::cerr << "GLFW: Vulkan not supported!\n";
-			return;
-		}
+			// Setup Vulkan
+			if (!glfwVulkanSupported())
+			{
+				std::cerr << "GLFW: Vulkan not supported!\n";
+				return;
+			}
 		
-		// Set icon
-		GLFWimage icon;
-		int channels;
-		if (!m_Specification.IconPath.empty())
-		{
-			std::string iconPathStr = m_Specification.IconPath.string();
-			icon.pixels = stbi_load(iconPathStr.c_str(), &icon.width, &icon.height, &channels, 4);
-			glfwSetWindowIcon(m_WindowHandle, 1, &icon);
-			stbi_image_free(icon.pixels);
+			// Set icon
+			if (windowIcon.Image)
+			{
+				m_JobSystem->Wait(windowIcon.Job);
+				if (windowIcon.Image->Data)
+				{
+					GLFWimage icon;
+					icon.width = (int)windowIcon.Image->Width;
+					icon.height = (int)windowIcon.Image->Height;
+					icon.pixels = (unsigned char*)windowIcon.Image->Data;
+					glfwSetWindowIcon(m_WindowHandle, 1, &icon);
+				}
+			}
+
+			glfwSetWindowUserPointer(m_WindowHandle, this);
+			glfwSetTitlebarHitTestCallback(m_WindowHandle, [](GLFWwindow* window, int x, int y, int* hit)
+			{
+				// No application while a soft restart is in progress
+				Application* app = (Application*)glfwGetWindowUserPointer(window);
+				*hit = app && app->IsTitleBarHovered();
+			});
 		}
 
-		glfwSetWindowUserPointer(m_WindowHandle, this);
-		glfwSetTitlebarHitTestCallback(m_WindowHandle, [](GLFWwindow* window, int x, int y, int* hit)
+		ImGui_ImplVulkanH_Window* wd = &g_MainWindowData;
 		{
-			Application* app = (Application*)glfwGetWindowUserPointer(window);
-			*hit = app->IsTitleBarHovered();
-		});
+			StartupPhaseScope phase(m_StartupPhases, "Vulkan");
 
-		uint32_t extensions_count = 0;
-		const char** extensions = glfwGetRequiredInstanceExtensions(&extensions_count);
-		SetupVulkan(extensions, extensions_count);
+			uint32_t extensions_count = 0;
+			const char** extensions = m_Specification.Offscreen ? nullptr : glfwGetRequiredInstanceExtensions(&extensions_count);
+			SetupVulkan(extensions, extensions_count, !m_Specification.Offscreen);
 
-		// Create Window Surface
-		VkSurfaceKHR surface;
-		VkResult err = glfwCreateWindowSurface(g_Instance, m_WindowHandle, g_Allocator, &surface);
-		check_vk_result(err);
+			PipelineCache::Init(g_Device, g_PhysicalDevice, m_Specification.PersistentPipelineCache ? m_CacheDirectory / "pipelines.bin" : std::filesystem::path());
 
-		// Create Framebuffers
-		int w, h;
-		glfwGetFramebufferSize(m_WindowHandle, &w, &h);
-		ImGui_ImplVulkanH_Window* wd = &g_MainWindowData;
-		SetupVulkanWindow(wd, surface, w, h);
-
-		s_AllocatedCommandBuffers.resize(wd->ImageCount);
-		s_ResourceFreeQueue.resize(wd->ImageCount);
-
-		// Setup Dear ImGui context
-		IMGUI_CHECKVERSION();
-		ImGui::CreateContext();
-		ImGuiIO& io = ImGui::GetIO(); (void)io;
-		io.ConfigFlags |= ImGuiConfigFlags_NavEnableKeyboard;       // Enable Keyboard Controls
-		//io.ConfigFlags |= ImGuiConfigFlags_NavEnableGamepad;      // Enable Gamepad Controls
-		io.ConfigFlags |= ImGuiConfigFlags_DockingEnable;           // Enable Docking
-		io.ConfigFlags |= ImGuiConfigFlags_ViewportsEnable;         // Enable Multi-Viewport / Platform Windows
-		//io.ConfigViewportsNoAutoMerge = true;
-		//io.ConfigViewportsNoTaskBarIcon = true;
-
-		// Theme colors
-		UI::SetHazelTheme();
-
-		// Style
-		ImGuiStyle& style = ImGui::GetStyle();
-		style.WindowPadding = ImVec2(10.0f, 10.0f);
-		style.FramePadding = ImVec2(8.0f, 6.0f);
-		style.ItemSpacing = ImVec2(6.0f, 6.0f);
-		style.ChildRounding = 6.0f;
-		style.PopupRounding = 6.0f;
-		style.FrameRounding = 6.0f;
-		style.WindowTitleAlign = ImVec2(0.5f, 0.5f);
-
-		// When viewports are enabled we tweak WindowRounding/WindowBg so platform windows can look identical to regular ones.
-		if (io.ConfigFlags & ImGuiConfigFlags_ViewportsEnable)
-		{
-			style.WindowRounding = 0.0f;
-			style.Colors[ImGuiCol_WindowBg].w = 1.0f;
+			MemoryAllocator::Init(g_Device, g_PhysicalDevice);
+			GPUTimeline::Init(g_Device);
+			s_UploadQueue = std::make_unique<UploadQueue>(g_Device, g_QueueFamily, m_Specification.UploadRingSize);
 		}
 
-		// Setup Platform/Renderer backends
-		ImGui_ImplGlfw_InitForVulkan(m_WindowHandle, true);
-		ImGui_ImplVulkan_InitInfo init_info = {};
-		init_info.Instance = g_Instance;
-		init_info.PipelineInfoMain.RenderPass = wd->RenderPass;
-		init_info.PipelineInfoForViewports.RenderPass = wd->RenderPass;
-		init_info.PhysicalDevice = g_PhysicalDevice;
-		init_info.Device = g_Device;
-		init_info.QueueFamily = g_QueueFamily;
-		init_info.Queue = g_Queue;
-		init_info.PipelineCache = g_PipelineCache;
-		init_info.DescriptorPool = g_DescriptorPool;
-		init_info.PipelineInfoMain.Subpass = 0;
-		init_info.PipelineInfoForViewports.Subpass = 0;
-		init_info.MinImageCount = g_MinImageCount;
-		init_info.ImageCount = wd->ImageCount;
-		init_info.PipelineInfoMain.MSAASamples = VK_SAMPLE_COUNT_1_BIT;
-		init_info.PipelineInfoForViewports.MSAASamples = VK_SAMPLE_COUNT_1_BIT;
-		init_info.Allocator = g_Allocator;
-		init_info.CheckVkResultFn = check_vk_result;
-		ImGui_ImplVulkan_Init(&init_info);
-
-		// Load default font
-		ImFontConfig fontConfig;
-		fontConfig.FontDataOwnedByAtlas = false;
-		ImFont* robotoFont = io.Fonts->AddFontFromMemoryTTF((void*)g_RobotoRegular, sizeof(g_RobotoRegular), 20.0f, &fontConfig);
-		s_Fonts["Default"] = robotoFont;
-		s_Fonts["Bold"] = io.Fonts->AddFontFromMemoryTTF((void*)g_RobotoBold, sizeof(g_RobotoBold), 20.0f, &fontConfig);
-		s_Fonts["Italic"] = io.Fonts->AddFontFromMemoryTTF((void*)g_RobotoItalic, sizeof(g_RobotoItalic), 20.0f, &fontConfig);
-		io.FontDefault = robotoFont;
-
-		// Upload Fonts
 		{
-			// Use any command queue
-			// VkCommandPool command_pool = wd->Frames[wd->FrameIndex].CommandPool;
-			// VkCommandBuffer command_buffer = wd->Frames[wd->FrameIndex].CommandBuffer;
-
-			// err = vkResetCommandPool(g_Device, command_pool, 0);
-			// check_vk_result(err);
-			// VkCommandBufferBeginInfo begin_info = {};
-			// begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-			// begin_info.flags |= VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-			// err = vkBeginCommandBuffer(command_buffer, &begin_info);
-			// check_vk_result(err);
-
-			// ImGui_ImplVulkan_CreateFontsTexture();
-
-			// VkSubmitInfo end_info = {};
-			// end_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-			// end_info.commandBufferCount = 1;
-			// end_info.pCommandBuffers = &command_buffer;
-			// err = vkEndCommandBuffer(command_buffer);
-			// check_vk_result(err);
-			// err = vkQueueSubmit(g_Queue, 1, &end_info, VK_NULL_HANDLE);
-			// check_vk_result(err);
-
-			// err = vkDeviceWaitIdle(g_Device);
-			// check_vk_result(err);
-			// ImGui_ImplVulkan_DestroyFontUploadObjects();
-		}
+			StartupPhaseScope phase(m_StartupPhases, "Swapchain");
 
-		// Load images
-		{
-			uint32_t w, h;
-			void* data = Image::Decode(g_WalnutIcon, sizeof(g_WalnutIcon), w, h);
-			m_AppHeaderIcon = std::make_shared<Walnut::Image>(w, h, ImageFormat::RGBA, data);
-			free(data);
-		}
-		{
-			uint32_t w, h;
-			void* data = Image::Decode(g_WindowMinimizeIcon, sizeof(g_WindowMinimizeIcon), w, h);
-			m_IconMinimize = std::make_shared<Walnut::Image>(w, h, ImageFormat::RGBA, data);
-			free(data);
+			if (m_Specification.Offscreen)
+			{
+				// Offscreen images stand in for the swapchain
+				s_OffscreenTarget = std::make_unique<OffscreenTarget>(wd, m_Specification.Width, m_Specification.Height, g_QueueFamily, g_MinImageCount);
+				s_OffscreenTarget->SetCapture(m_Specification.OffscreenCaptureDirectory, m_Specification.OffscreenCaptureInterval);
+			}
+			else
+			{
+				// Create Window Surface
+				VkSurfaceKHR surface;
+				VkResult err = glfwCreateWindowSurface(g_Instance, m_WindowHandle, g_Allocator, &surface);
+				check_vk_result(err);
+
+				// Create Framebuffers
+				int w, h;
+				glfwGetFramebufferSize(m_WindowHandle, &w, &h);
+				SetupVulkanWindow(wd, surface, w, h);
+			}
+
+			s_AllocatedCommandBuffers.resize(wd->ImageCount);
 		}
+
 		{
-			uint32_t w, h;
-			void* data = Image::Decode(g_WindowMaximizeIcon, sizeof(g_WindowMaximizeIcon), w, h);
-			m_IconMaximize = std::make_shared<Walnut::Image>(w, h, ImageFormat::RGBA, data);
-			free(data);
+			StartupPhaseScope phase(m_StartupPhases, "ImGui");
+
+			// Setup Dear ImGui context
+			IMGUI_CHECKVERSION();
+			ImGui::CreateContext();
+			ImGuiIO& io = ImGui::GetIO(); (void)io;
+			io.ConfigFlags |= ImGuiConfigFlags_NavEnableKeyboard;       // Enable Keyboard Controls
+			//io.ConfigFlags |= ImGuiConfigFlags_NavEnableGamepad;      // Enable Gamepad Controls
+			io.ConfigFlags |= ImGuiConfigFlags_DockingEnable;           // Enable Docking
+			if (!m_Specification.Offscreen)
+				io.ConfigFlags |= ImGuiConfigFlags_ViewportsEnable;     // Enable Multi-Viewport / Platform Windows
+			//io.ConfigViewportsNoAutoMerge = true;
+			//io.ConfigViewportsNoTaskBarIcon = true;
+
+			// Theme colors
+			UI::SetHazelTheme();
+
+			// Style
+			ImGuiStyle& style = ImGui::GetStyle();
+			style.WindowPadding = ImVec2(10.0f, 10.0f);
+			style.FramePadding = ImVec2(8.0f, 6.0f);
+			style.ItemSpacing = ImVec2(6.0f, 6.0f);
+			style.ChildRounding = 6.0f;
+			style.PopupRounding = 6.0f;
+			style.FrameRounding = 6.0f;
+			style.WindowTitleAlign = ImVec2(0.5f, 0.5f);
+
+			// When viewports are enabled we tweak WindowRounding/WindowBg so platform windows can look identical to regular ones.
+			if (io.ConfigFlags & ImGuiConfigFlags_ViewportsEnable)
+			{
+				style.WindowRounding = 0.0f;
+				style.Colors[ImGuiCol_WindowBg].w = 1.0f;
+			}
+
+			// Setup Platform/Renderer backends
+			// Offscreen there is no platform backend, Run sets the display size and timestep itself
+			if (!m_Specification.Offscreen)
+				ImGui_ImplGlfw_InitForVulkan(m_WindowHandle, true);
+			ImGui_ImplVulkan_InitInfo init_info = {};
+			init_info.ApiVersion = VK_API_VERSION_1_2;
+			init_info.Instance = g_Instance;
+			init_info.PipelineInfoMain.RenderPass = wd->RenderPass;
+			init_info.PipelineInfoForViewports.RenderPass = wd->RenderPass;
+			init_info.PhysicalDevice = g_PhysicalDevice;
+			init_info.Device = g_Device;
+			init_info.QueueFamily = g_QueueFamily;
+			init_info.Queue = g_Queue;
+			init_info.PipelineCache = PipelineCache::Get();
+			init_info.DescriptorPool = g_DescriptorPool;
+			init_info.PipelineInfoMain.Subpass = 0;
+			init_info.PipelineInfoForViewports.Subpass = 0;
+			init_info.MinImageCount = g_MinImageCount;
+			init_info.ImageCount = wd->ImageCount;
+			init_info.PipelineInfoMain.MSAASamples = VK_SAMPLE_COUNT_1_BIT;
+			init_info.PipelineInfoForViewports.MSAASamples = VK_SAMPLE_COUNT_1_BIT;
+			init_info.Allocator = g_Allocator;
+			init_info.CheckVkResultFn = check_vk_result;
+			ImGui_ImplVulkan_Init(&init_info);
 		}
+
 		{
-			uint32_t w, h;
-			void* data = Image::Decode(g_WindowRestoreIcon, sizeof(g_WindowRestoreIcon), w, h);
-			m_IconRestore = std::make_shared<Walnut::Image>(w, h, ImageFormat::RGBA, data);
-			free(data);
+			StartupPhaseScope phase(m_StartupPhases, "Fonts");
+
+			// Load default font
+			// Glyphs are baked on first use by the dynamic font atlas, and come
+			// from the font cache when an earlier run already rasterized them
+			ImGuiIO& io = ImGui::GetIO();
+			m_JobSystem->Wait(fontCacheJob);
+			UI::FontCache::Init(io.Fonts, fontCachePath);
+
+			ImFontConfig fontConfig;
+			fontConfig.FontDataOwnedByAtlas = false;
+			ImFont* robotoFont = io.Fonts->AddFontFromMemoryTTF((void*)g_RobotoRegular, sizeof(g_RobotoRegular), 20.0f, &fontConfig);
+			s_Fonts["Default"] = robotoFont;
+			s_Fonts["Bold"] = io.Fonts->AddFontFromMemoryTTF((void*)g_RobotoBold, sizeof(g_RobotoBold), 20.0f, &fontConfig);
+			s_Fonts["Italic"] = io.Fonts->AddFontFromMemoryTTF((void*)g_RobotoItalic, sizeof(g_RobotoItalic), 20.0f, &fontConfig);
+			io.FontDefault = robotoFont;
 		}
+
 		{
-			uint32_t w, h;
-			void* data = Image::Decode(g_WindowCloseIcon, sizeof(g_WindowCloseIcon), w, h);
-			m_IconClose = std::make_shared<Walnut::Image>(w, h, ImageFormat::RGBA, data);
-			free(data);
+			StartupPhaseScope phase(m_StartupPhases, "Images");
+
+			// Load images
+			// Decoded on workers while the device was created, usually done by now
+			m_JobSystem->Wait({ appHeaderIcon.Job, minimizeIcon.Job, maximizeIcon.Job, restoreIcon.Job, closeIcon.Job });
+
+			m_AppHeaderIcon = std::make_shared<Walnut::Image>(appHeaderIcon.Image->Width, appHeaderIcon.Image->Height, ImageFormat::RGBA, appHeaderIcon.Image->Data);
+
+			// Window button icons share a page of the application atlas
+			m_ImageAtlas = std::make_unique<ImageAtlas>(256);
+			m_IconMinimize = m_ImageAtlas->Add(minimizeIcon.Image->Width, minimizeIcon.Image->Height, minimizeIcon.Image->Data);
+			m_IconMaximize = m_ImageAtlas->Add(maximizeIcon.Image->Width, maximizeIcon.Image->Height, maximizeIcon.Image->Data);
+			m_IconRestore = m_ImageAtlas->Add(restoreIcon.Image->Width, restoreIcon.Image->Height, restoreIcon.Image->Data);
+			m_IconClose = m_ImageAtlas->Add(closeIcon.Image->Width, closeIcon.Image->Height, closeIcon.Image->Data);
 		}
 
+		std::string phases;
+		for (const StartupPhase& phase : m_StartupPhases)
+			phases += std::format("{}{} {:.1f} ms", phases.empty() ? "" : ", ", phase.Name, Clock::ToMilliseconds(phase.Duration));
+		WL_CORE_INFO_TAG("Application", "Initialized in {:.1f} ms ({})", Clock::ToMilliseconds(GetTimeNs()), phases);
 	}
 
 	void Application::Shutdown()
 	{
+		const int64_t restartStart = Clock::Now();
+
 		for (auto& layer : m_LayerStack)
 			layer->OnDetach();
 
 		m_LayerStack.clear();
 
+		// Finish outstanding jobs before the resources they use go away
+		m_JobSystem.reset();
+
+		// Soft restart: hand the heavy subsystems to the next application instead of destroying them
+		if (m_RestartRequested)
+		{
+			s_RetainedState = std::make_unique<RetainedState>();
+			s_RetainedState->RestartStart = restartStart;
+			s_RetainedState->WindowHandle = m_WindowHandle;
+			s_RetainedState->AppHeaderIcon = std::move(m_AppHeaderIcon);
+			s_RetainedState->Atlas = std::move(m_ImageAtlas);
+			s_RetainedState->IconClose = m_IconClose;
+			s_RetainedState->IconMinimize = m_IconMinimize;
+			s_RetainedState->IconMaximize = m_IconMaximize;
+			s_RetainedState->IconRestore = m_IconRestore;
+
+			if (m_WindowHandle)
+				glfwSetWindowUserPointer(m_WindowHandle, nullptr);
+
+			// Images loaded by the application are application state
+			ImageCache::Clear();
+			return;
+		}
+
 		// Release resources
 		// NOTE(Yan): to avoid doing this manually, we shouldn't
 		//            store resources in this Application class
 		m_AppHeaderIcon.reset();
-		m_IconClose.reset();
-		m_IconMinimize.reset();
-		m_IconMaximize.reset();
-		m_IconRestore.reset();
+		m_IconClose = {};
+		m_IconMinimize = {};
+		m_IconMaximize = {};
+		m_IconRestore = {};
+		m_ImageAtlas.reset();
+		ImageCache::Clear();
 
 		// Cleanup
 		VkResult err = vkDeviceWaitIdle(g_Device);
 		check_vk_result(err);
 
-		// Free resources in queue
-		for (auto& queue : s_ResourceFreeQueue)
-		{
-			for (auto& func : queue)
-				func();
-		}
-		s_ResourceFreeQueue.clear();
+		// Free released resources
+		DeletionQueue::Flush();
+
+		s_UploadQueue.reset();
+		GPUTimeline::Shutdown();
+		SamplerCache::Shutdown();
+		MemoryAllocator::Shutdown();
 
 		ImGui_ImplVulkan_Shutdown();
-		ImGui_ImplGlfw_Shutdown();
+		PipelineCache::Shutdown();
+		UI::FontCache::Shutdown();
+		if (m_WindowHandle)
+			ImGui_ImplGlfw_Shutdown();
 		ImGui::DestroyContext();
 
-		CleanupVulkanWindow();
+		if (s_OffscreenTarget)
+			s_OffscreenTarget.reset();
+		else
+			CleanupVulkanWindow();
 		CleanupVulkan();
 
-		glfwDestroyWindow(m_WindowHandle);
-		glfwTerminate();
+		if (m_WindowHandle)
+		{
+			glfwDestroyWindow(m_WindowHandle);
+			glfwTerminate();
+		}
 
 		g_ApplicationRunning = false;
 
@@ -783,8 +1075,8 @@ namespace Walnut {
 		ImGui::Spring();
 		UI::ShiftCursorY(8.0f);
 		{
-			const int iconWidth = m_IconMinimize->GetWidth();
-			const int iconHeight = m_IconMinimize->GetHeight();
+			const int iconWidth = m_IconMinimize.Width;
+			const int iconHeight = m_IconMinimize.Height;
 			const float padY = (buttonHeight - (float)iconHeight) / 2.0f;
 			if (ImGui::InvisibleButton("Minimize", ImVec2(buttonWidth, buttonHeight)))
 			{
@@ -803,8 +1095,8 @@ namespace Walnut {
 		ImGui::Spring(-1.0f, 17.0f);
 		UI::ShiftCursorY(8.0f);
 		{
-			const int iconWidth = m_IconMaximize->GetWidth();
-			const int iconHeight = m_IconMaximize->GetHeight();
+			const int iconWidth = m_IconMaximize.Width;
+			const int iconHeight = m_IconMaximize.Height;
 
 			const bool isMaximized = IsMaximized();
 
@@ -826,8 +1118,8 @@ namespace Walnut {
 		ImGui::Spring(-1.0f, 15.0f);
 		UI::ShiftCursorY(8.0f);
 		{
-			const int iconWidth = m_IconClose->GetWidth();
-			const int iconHeight = m_IconClose->GetHeight();
+			const int iconWidth = m_IconClose.Width;
+			const int iconHeight = m_IconClose.Height;
 			if (ImGui::InvisibleButton("Close", ImVec2(buttonWidth, buttonHeight)))
 				Application::Get().Close();
 
@@ -877,30 +1169,61 @@ namespace Walnut {
 		ImVec4 clear_color = ImVec4(0.45f, 0.55f, 0.60f, 1.00f);
 		ImGuiIO& io = ImGui::GetIO();
 
+		if (m_Specification.MaxFPS > 0.0f)
+		{
+			// Reset: a slow frame pushes the next one back instead of causing a burst
+			m_FrameLimiter.SetRate(m_Specification.MaxFPS);
+			m_FrameLimiter.SetOverrunPolicy(TickOverrunPolicy::Reset);
+			m_FrameLimiter.Start();
+		}
+
 		// Main loop
-		while (!glfwWindowShouldClose(m_WindowHandle) && m_Running)
+		while (m_Running && (s_OffscreenTarget || !glfwWindowShouldClose(m_WindowHandle)))
 		{
+			if (s_OffscreenTarget && m_Specification.OffscreenFrameCount > 0 && s_OffscreenTarget->GetFrameCount() >= m_Specification.OffscreenFrameCount)
+				break;
+
+			if (m_Specification.MaxFPS > 0.0f)
+			{
+				WL_PROFILE_SCOPE("Application::FrameLimiter");
+				m_FrameLimiter.WaitForNextTick();
+			}
+
+			// Waits for the limiter and the GPU don't count as CPU time of the frame
+			const int64_t frameStartTime = GetTimeNs();
+			s_FenceWaitTime = 0;
+
+			if (m_Specification.EventDrivenRedraw && !s_OffscreenTarget)
+			{
+				WL_PROFILE_SCOPE("Application::WaitForRedraw");
+				WaitForRedraw();
+			}
+
+			WL_PROFILE_FRAME();
+			WL_ALLOCATION_FRAME();
+
 			// Poll and handle events (inputs, window resize, etc.)
 			// You can read the io.WantCaptureMouse, io.WantCaptureKeyboard flags to tell if dear imgui wants to use your inputs.
 			// - When io.WantCaptureMouse is true, do not dispatch mouse input data to your main application.
 			// - When io.WantCaptureKeyboard is true, do not dispatch keyboard input data to your main application.
 			// Generally you may always pass all inputs to dear imgui, and hide them from your application based on those two flags.
-			glfwPollEvents();
+			if (!m_Specification.EventDrivenRedraw && !s_OffscreenTarget)
+				glfwPollEvents();
 
 			{
-				std::scoped_lock<std::mutex> lock(m_EventQueueMutex);
+				WL_PROFILE_SCOPE("Application::ProcessEvents");
 
 				// Process custom event queue
-				while (m_EventQueue.size() > 0)
-				{
-					auto& func = m_EventQueue.front();
-					func();
-					m_EventQueue.pop();
-				}
+				m_EventQueue.Execute();
+
+				m_JobSystem->ExecuteMainThreadJobs();
 			}
 
 			for (auto& layer : m_LayerStack)
+			{
+				WL_PROFILE_SCOPE(Profiler::GetMemberZoneName(typeid(*layer), "OnUpdate"));
 				layer->OnUpdate(m_TimeStep);
+			}
 
 			// Resize swap chain?
 			if (g_SwapChainRebuild)
@@ -923,7 +1246,15 @@ namespace Walnut {
 
 			// Start the Dear ImGui frame
 			ImGui_ImplVulkan_NewFrame();
-			ImGui_ImplGlfw_NewFrame();
+			if (s_OffscreenTarget)
+			{
+				io.DisplaySize = ImVec2((float)wd->Width, (float)wd->Height);
+				io.DeltaTime = m_FrameTime > 0.0f ? m_FrameTime : 1.0f / 60.0f;
+			}
+			else
+			{
+				ImGui_ImplGlfw_NewFrame();
+			}
 			ImGui::NewFrame();
 
 			if (m_Specification.UseDockspace)
@@ -984,7 +1315,10 @@ namespace Walnut {
 					UI_DrawMenubar();
 
 				for (auto& layer : m_LayerStack)
+				{
+					WL_PROFILE_SCOPE(Profiler::GetMemberZoneName(typeid(*layer), "OnUIRender"));
 					layer->OnUIRender();
+				}
 
 				ImGui::End();
 			}
@@ -992,11 +1326,17 @@ namespace Walnut {
 			{
 				// No dockspace - just render windows
 				for (auto& layer : m_LayerStack)
+				{
+					WL_PROFILE_SCOPE(Profiler::GetMemberZoneName(typeid(*layer), "OnUIRender"));
 					layer->OnUIRender();
+				}
 			}
 
 			// Rendering
-			ImGui::Render();
+			{
+				WL_PROFILE_SCOPE("ImGui::Render");
+				ImGui::Render();
+			}
 			ImDrawData* main_draw_data = ImGui::GetDrawData();
 			const bool main_is_minimized = (main_draw_data->DisplaySize.x <= 0.0f || main_draw_data->DisplaySize.y <= 0.0f);
 			wd->ClearValue.color.float32[0] = clear_color.x * clear_color.w;
@@ -1006,25 +1346,54 @@ namespace Walnut {
 			if (!main_is_minimized)
 				FrameRender(this, wd, main_draw_data);
 
+			if (s_OffscreenTarget)
+				s_OffscreenTarget->SetFrameCPUTime(wd->FrameIndex, Clock::ToMilliseconds(GetTimeNs() - frameStartTime - s_FenceWaitTime));
+
 			// Update and Render additional Platform Windows
 			if (io.ConfigFlags & ImGuiConfigFlags_ViewportsEnable)
 			{
+				WL_PROFILE_SCOPE("ImGui::RenderPlatformWindows");
 				ImGui::UpdatePlatformWindows();
 				ImGui::RenderPlatformWindowsDefault();
 			}
 
 			// Present Main Platform Window
 			if (!main_is_minimized)
-				FramePresent(wd);
-			else
+			{
+				if (!s_OffscreenTarget)
+					FramePresent(wd);
+
+				if (m_TimeToFirstFrame == 0)
+				{
+					m_TimeToFirstFrame = GetTimeNs();
+					WL_CORE_INFO_TAG("Application", "First frame after {:.1f} ms", Clock::ToMilliseconds(m_TimeToFirstFrame));
+				}
+			}
+			else if (!m_Specification.EventDrivenRedraw)
 				std::this_thread::sleep_for(std::chrono::milliseconds(5));
 
-			float time = GetTime();
-			m_FrameTime = time - m_LastFrameTime;
+			// No frame to carry the uploads this time
+			if (main_is_minimized || g_SwapChainRebuild)
+			{
+				s_UploadQueue->Submit(g_Queue);
+				DeletionQueue::Collect(g_Queue);
+			}
+
+			// Only the difference goes to floating point, so the timestep stays exact regardless of uptime
+			const int64_t time = GetTimeNs();
+			m_FrameTime = (float)Clock::ToSeconds(time - m_LastFrameTime);
 			m_TimeStep = glm::min<float>(m_FrameTime, 0.0333f);
 			m_LastFrameTime = time;
 		}
 
+		if (s_OffscreenTarget)
+		{
+			VkResult err = vkDeviceWaitIdle(g_Device);
+			check_vk_result(err);
+
+			s_OffscreenTarget->CollectAll();
+			s_OffscreenTarget->LogSummary();
+		}
 	}
 
 	void Application::SetMenubarCallback(const std::function<void()>& menubarCallback)
@@ -1038,16 +1407,64 @@ namespace Walnut {
 	void Application::Close()
 	{
 		m_Running = false;
+		WakeMainLoop();
+	}
+
+	void Application::Restart()
+	{
+		m_RestartRequested = true;
+		Close();
+	}
+
+	void Application::WakeMainLoop()
+	{
+		// Offscreen the loop never waits
+		if (m_WindowHandle)
+			glfwPostEmptyEvent();
+	}
+
+	void Application::RequestRedraw()
+	{
+		m_RedrawRequested.store(true, std::memory_order_release);
+
+		// The main thread checks the flag before it waits
+		if (std::this_thread::get_id() != m_MainThreadID)
+			WakeMainLoop();
+	}
+
+	void Application::WaitForRedraw()
+	{
+		// ImGui needs a few frames to settle after input (hover, activation, popups)
+		constexpr uint32_t InputRedrawFrames = 3;
+
+		const bool redrawRequested = m_RedrawRequested.exchange(false, std::memory_order_acquire);
+		if (m_RedrawFrames == 0 && !redrawRequested && m_EventQueue.IsEmpty())
+		{
+			// Queued events, main-thread jobs and RequestRedraw from other threads post an empty event
+			if (m_Specification.IdleFPS > 0.0f)
+				glfwWaitEventsTimeout(1.0 / m_Specification.IdleFPS);
+			else
+				glfwWaitEvents();
+		}
+		else
+		{
+			glfwPollEvents();
+		}
+
+		if (ImGui::GetCurrentContext()->InputEventsQueue.Size > 0)
+			m_RedrawFrames = InputRedrawFrames;
+		else if (m_RedrawFrames > 0)
+			m_RedrawFrames--;
 	}
 
 	bool Application::IsMaximized() const
 	{
-		return (bool)glfwGetWindowAttrib(m_WindowHandle, GLFW_MAXIMIZED);
+		return m_WindowHandle && (bool)glfwGetWindowAttrib(m_WindowHandle, GLFW_MAXIMIZED);
 	}
 
 	float Application::GetTime()
 	{
-		return (float)glfwGetTime();
+		return (float)GetTimeSeconds();
 	}
 
 	VkInstance Application::GetInstance()
@@ -1065,6 +1482,16 @@ namespace Walnut {
 		return g_Device;
 	}
 
+	UploadQueue& Application::GetUploadQueue()
+	{
+		return *s_UploadQueue;
+	}
+
+	OffscreenTarget* Application::GetOffscreenTarget()
+	{
+		return s_OffscreenTarget.get();
+	}
+
 	VkCommandBuffer Application::GetCommandBuffer(bool begin)
 	{
 		ImGui_ImplVulkanH_Window* wd = &g_MainWindowData;
@@ -1121,7 +1548,7 @@ namespace Walnut {
 
 	void Application::SubmitResourceFree(std::function<void()>&& func)
 	{
-		s_ResourceFreeQueue[s_CurrentFrameIndex].emplace_back(func);
+		DeletionQueue::Release(std::move(func));
 	}
 
 	ImFont* Application::GetFont(const std::string& name)
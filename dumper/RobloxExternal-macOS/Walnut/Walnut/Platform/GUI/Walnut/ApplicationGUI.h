@@ -2,12 +2,18 @@
 
 #include "Walnut/Layer.h"
 #include "Walnut/Image.h"
+#include "Walnut/ImageAtlas.h"
+#include "Walnut/Timer.h"
+#include "Walnut/TickScheduler.h"
+#include "Walnut/Core/JobSystem.h"
+#include "Walnut/Core/EventQueue.h"
 
 #include <string>
 #include <vector>
-#include <queue>
 #include <mutex>
 #include <memory>
+#include <atomic>
+#include <thread>
 #include <functional>
 #include <filesystem>
 
@@ -22,6 +28,9 @@ struct GLFWwindow;
 
 namespace Walnut {
 
+	class UploadQueue;
+	class OffscreenTarget;
+
 	struct ApplicationSpecification
 	{
 		std::string Name = "Walnut App";
@@ -43,6 +52,59 @@ namespace Walnut {
 		// Window will be created in the center
 		// of primary monitor
 		bool CenterWindow = false;
+
+		// Only redraw when there is input, a queued event or main-thread job,
+		// or a redraw was requested (see Application::RequestRedraw),
+		// instead of redrawing continuously
+		bool EventDrivenRedraw = false;
+
+		// Frame rate limit, 0 = limited by the swapchain only
+		float MaxFPS = 0.0f;
+
+		// Redraw rate while idle with EventDrivenRedraw,
+		// 0 = sleep until the next event
+		float IdleFPS = 0.0f;
+
+		// Size in bytes of the staging ring used for texture uploads,
+		// larger uploads get a temporary buffer of their own
+		uint64_t UploadRingSize = 32 * 1024 * 1024;
+
+		// Worker threads of the application JobSystem,
+		// 0 = one per hardware thread minus the main thread
+		uint32_t WorkerThreadCount = 0;
+
+		// Size in bytes of the crash-safe log ring buffer
+		// that replaces the log files, 0 keeps the files
+		uint64_t LogRingBufferSize = 0;
+
+		// Where caches like the Vulkan pipeline cache are kept,
+		// empty = the platform's per-user cache directory
+		std::filesystem::path CacheDirectory;
+
+		// Keep compiled pipelines between runs (see PipelineCache)
+		bool PersistentPipelineCache = true;
+
+		// Keep rasterized glyphs between runs (see UI::FontCache)
+		bool PersistentFontCache = true;
+
+		// Renders into offscreen images instead of a window: no GLFW window, surface or
+		// swapchain, so the render path runs on build machines with software Vulkan (lavapipe).
+		// Width and Height are the image size, frame timings are logged when Run returns.
+		bool Offscreen = false;
+
+		// Offscreen frames to render before Run returns, 0 = until Close()
+		uint32_t OffscreenFrameCount = 0;
+
+		// Every OffscreenCaptureInterval-th offscreen frame is written to this
+		// directory as a PPM image, empty = no captures
+		std::filesystem::path OffscreenCaptureDirectory;
+		uint32_t OffscreenCaptureInterval = 1;
+	};
+
+	struct StartupPhase
+	{
+		const char* Name = nullptr;
+		int64_t Duration = 0; // Nanoseconds
 	};
 
 	class Application
@@ -52,6 +114,9 @@ namespace Walnut {
 		~Application();
 
 		static Application& Get();
+		// Thread-safe, nullptr while no application exists (before the first one,
+		// between the instances of a soft restart and after shutdown)
+		static Application* TryGet();
 
 		void Run();
 		void SetMenubarCallback(const std::function<void()>& menubarCallback);
@@ -69,30 +134,70 @@ namespace Walnut {
 
 		void Close();
 
+		// Ends Run like Close, after which Walnut::Main creates the application again. The window,
+		// Vulkan device, ImGui context with its font atlas and the loggers stay alive, only the
+		// layers and application state are rebuilt, so config reloads take milliseconds.
+		// Window and device settings of the new specification are ignored, except the title.
+		void Restart();
+
 		bool IsMaximized() const;
 		std::shared_ptr<Image> GetApplicationIcon() const { return m_AppHeaderIcon; }
 
+		// Time since the application started. Keep long spans in GetTimeNs, the float
+		// version loses precision after a few days of uptime.
+		int64_t GetTimeNs() const { return m_AppTimer.ElapsedNanoseconds(); }
+		double GetTimeSeconds() const { return m_AppTimer.ElapsedSeconds(); }
 		float GetTime();
 		GLFWwindow* GetWindowHandle() const { return m_WindowHandle; }
 		bool IsTitleBarHovered() const { return m_TitleBarHovered; }
 
+		JobSystem& GetJobSystem() { return *m_JobSystem; }
+
+		// Durations of the Init phases in order, logged at startup
+		const std::vector<StartupPhase>& GetStartupPhases() const { return m_StartupPhases; }
+		// Nanoseconds from construction until the first frame was presented, 0 before that
+		int64_t GetTimeToFirstFrame() const { return m_TimeToFirstFrame; }
+
+		const std::filesystem::path& GetCacheDirectory() const { return m_CacheDirectory; }
+
+		// Shared atlas for small static images like icons (main thread only)
+		ImageAtlas& GetImageAtlas() { return *m_ImageAtlas; }
+
 		static VkInstance GetInstance();
 		static VkPhysicalDevice GetPhysicalDevice();
 		static VkDevice GetDevice();
 
+		// Batched texture uploads, recorded at the start of the next frame
+		static UploadQueue& GetUploadQueue();
+
+		// Frame timings and captures with ApplicationSpecification::Offscreen, nullptr otherwise
+		static OffscreenTarget* GetOffscreenTarget();
+
 		static VkCommandBuffer GetCommandBuffer(bool begin);
 		static void FlushCommandBuffer(VkCommandBuffer commandBuffer);
 
+		// Thread-safe, func runs once the GPU is done with all work submitted so far.
+		// Prefer the typed DeletionQueue releases, they don't allocate.
 		static void SubmitResourceFree(std::function<void()>&& func);
 
 		static ImFont* GetFont(const std::string& name);
 
+		// Thread-safe, runs func on the main thread at the start of the next frame
 		template<typename Func>
 		void QueueEvent(Func&& func)
 		{
-			m_EventQueue.push(func);
+			// Only the event that makes the queue non-empty has to wake the loop
+			if (m_EventQueue.Push(std::forward<Func>(func)))
+				WakeMainLoop();
 		}
 
+		// Thread-safe, makes a main loop waiting for window events run its next frame right away
+		void WakeMainLoop();
+
+		// Thread-safe, draws at least one more frame with EventDrivenRedraw.
+		// Layers that animate call this every frame while the animation runs.
+		void RequestRedraw();
+
 		static ImGui_ImplVulkanH_Window* GetMainWindowData();
 		static VkCommandBuffer GetActiveCommandBuffer();
 	private:
@@ -102,31 +207,48 @@ namespace Walnut {
 		// For custom titlebars
 		void UI_DrawTitlebar(float& outTitlebarHeight);
 		void UI_DrawMenubar();
+
+		// Polls window events, or waits for them while there is nothing to redraw
+		void WaitForRedraw();
 	private:
 		ApplicationSpecification m_Specification;
 		GLFWwindow* m_WindowHandle = nullptr;
-		bool m_Running = false;
+		// Close() may be called from any thread
+		std::atomic<bool> m_Running = false;
+		bool m_RestartRequested = false;
 
 		float m_TimeStep = 0.0f;
 		float m_FrameTime = 0.0f;
-		float m_LastFrameTime = 0.0f;
+		int64_t m_LastFrameTime = 0;
 
 		bool m_TitleBarHovered = false;
 
 		std::vector<std::shared_ptr<Layer>> m_LayerStack;
 		std::function<void()> m_MenubarCallback;
+		Timer m_AppTimer;
+
+		TickScheduler m_FrameLimiter;
+		std::thread::id m_MainThreadID;
+		std::atomic<bool> m_RedrawRequested = false;
+		uint32_t m_RedrawFrames = 0;
+
+		std::unique_ptr<JobSystem> m_JobSystem;
+		std::filesystem::path m_CacheDirectory;
+
+		std::vector<StartupPhase> m_StartupPhases;
+		int64_t m_TimeToFirstFrame = 0;
 
-		std::mutex m_EventQueueMutex;
-		std::queue<std::function<void()>> m_EventQueue;
+		EventQueue m_EventQueue;
 
 		// Resources
 		// TODO(Yan): move out of application class since this can't be tied
 		//            to application lifetime
 		std::shared_ptr<Walnut::Image> m_AppHeaderIcon;
-		std::shared_ptr<Walnut::Image> m_IconClose;
-		std::shared_ptr<Walnut::Image> m_IconMinimize;
-		std::shared_ptr<Walnut::Image> m_IconMaximize;
-		std::shared_ptr<Walnut::Image> m_IconRestore;
+		std::unique_ptr<ImageAtlas> m_ImageAtlas;
+		AtlasImage m_IconClose;
+		AtlasImage m_IconMinimize;
+		AtlasImage m_IconMaximize;
+		AtlasImage m_IconRestore;
 	};
 
 	// Implemented by CLIENT
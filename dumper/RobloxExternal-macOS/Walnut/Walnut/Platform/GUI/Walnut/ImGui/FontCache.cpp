@@ -0,0 +1,421 @@
+#include "FontCache.h"
+
+#include "Walnut/Core/Log.h"
+
+#include "imgui_internal.h"
+#ifdef IMGUI_ENABLE_FREETYPE
+#include "misc/freetype/imgui_freetype.h"
+#endif
+
+#include <cstring>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Walnut::UI {
+
+	namespace {
+
+		constexpr uint32_t s_Magic = 0x43465657; // "WVFC"
+		constexpr uint32_t s_Version = 1;
+
+		// Glyphs rasterized past this are not cached
+		constexpr size_t s_MaxPixelsSize = 32 * 1024 * 1024;
+
+		struct FileHeader
+		{
+			uint32_t Magic = s_Magic;
+			uint32_t Version = s_Version;
+			uint32_t ImGuiVersion = IMGUI_VERSION_NUM;
+			uint32_t GlyphCount = 0;
+			uint64_t LoaderHash = 0;
+			uint64_t PixelsSize = 0;
+			uint64_t DataHash = 0;
+		};
+
+		struct GlyphEntry
+		{
+			float X0, Y0, X1, Y1;
+			float AdvanceX;
+			uint16_t Width, Height;
+			uint32_t PixelOffset;
+		};
+
+		struct FileGlyph
+		{
+			uint64_t Key;
+			GlyphEntry Glyph;
+		};
+
+		constexpr uint64_t s_HashBasis = 14695981039346656037ull;
+
+		// FNV-1a, eight bytes at a time
+		uint64_t HashBytes(const void* data, size_t size, uint64_t hash = s_HashBasis)
+		{
+			const uint8_t* bytes = (const uint8_t*)data;
+			while (size >= 8)
+			{
+				uint64_t word;
+				memcpy(&word, bytes, 8);
+				hash = (hash ^ word) * 1099511628211ull;
+				bytes += 8;
+				size -= 8;
+			}
+			while (size-- > 0)
+				hash = (hash ^ *bytes++) * 1099511628211ull;
+			return hash;
+		}
+
+		template<typename T>
+		uint64_t HashValue(const T& value, uint64_t hash)
+		{
+			return HashBytes(&value, sizeof(T), hash);
+		}
+
+		struct CacheFile
+		{
+			uint64_t LoaderHash = 0;
+			std::vector<FileGlyph> Glyphs;
+			std::vector<uint8_t> Pixels;
+		};
+
+		// Reads and verifies the file, the loader hash is checked by the caller. Thread-safe.
+		std::optional<CacheFile> ReadCacheFile(const std::filesystem::path& filepath)
+		{
+			std::ifstream stream(filepath, std::ios::binary);
+			if (!stream)
+				return {};
+
+			FileHeader header;
+			if (!stream.read((char*)&header, sizeof(FileHeader)))
+				return {};
+
+			if (header.Magic != s_Magic || header.Version != s_Version
+				|| header.ImGuiVersion != IMGUI_VERSION_NUM || header.PixelsSize > s_MaxPixelsSize)
+			{
+				return {};
+			}
+
+			// The counts come from disk, check them against the file before allocating
+			std::error_code error;
+			const uint64_t fileSize = std::filesystem::file_size(filepath, error);
+			const uint64_t dataSize = fileSize - sizeof(FileHeader);
+			if (error || header.GlyphCount > dataSize / sizeof(FileGlyph)
+				|| header.PixelsSize > dataSize - (uint64_t)header.GlyphCount * sizeof(FileGlyph))
+			{
+				WL_CORE_WARN_TAG("UI", "Font cache {} is truncated, rebuilding it", filepath.string());
+				return {};
+			}
+
+			CacheFile file;
+			file.LoaderHash = header.LoaderHash;
+			file.Glyphs.resize(header.GlyphCount);
+			file.Pixels.resize(header.PixelsSize);
+			stream.read((char*)file.Glyphs.data(), (std::streamsize)(file.Glyphs.size() * sizeof(FileGlyph)));
+			stream.read((char*)file.Pixels.data(), (std::streamsize)file.Pixels.size());
+
+			uint64_t hash = HashBytes(file.Glyphs.data(), file.Glyphs.size() * sizeof(FileGlyph));
+			hash = HashBytes(file.Pixels.data(), file.Pixels.size(), hash);
+			if (!stream || hash != header.DataHash)
+			{
+				WL_CORE_WARN_TAG("UI", "Font cache {} is corrupt, rebuilding it", filepath.string());
+				return {};
+			}
+
+			for (const FileGlyph& glyph : file.Glyphs)
+			{
+				if ((uint64_t)glyph.Glyph.PixelOffset + (uint64_t)glyph.Glyph.Width * glyph.Glyph.Height > file.Pixels.size())
+					return {};
+			}
+
+			return file;
+		}
+
+	}
+
+	static ImFontLoader s_Loader;
+	static const ImFontLoader* s_InnerLoader = nullptr;
+	static std::string s_LoaderName;
+	static std::filesystem::path s_Filepath;
+
+	static std::unordered_map<uint64_t, GlyphEntry> s_Glyphs;
+	static std::vector<uint8_t> s_Pixels; // Alpha8
+	static bool s_Dirty = false;
+
+	// Read ahead of Init by Preload
+	static std::filesystem::path s_PreloadedFilepath;
+	static std::optional<CacheFile> s_PreloadedFile;
+
+	// Hash of the font data, by data pointer (the atlas keeps it alive while the source exists)
+	static std::unordered_map<const void*, uint64_t> s_FontDataHashes;
+
+	static uint64_t GetLoaderHash()
+	{
+		return HashBytes(s_InnerLoader->Name, strlen(s_InnerLoader->Name));
+	}
+
+	static uint64_t GetGlyphKey(ImFontAtlas* atlas, ImFontConfig* src, ImFontBaked* baked, ImWchar codepoint)
+	{
+		auto it = s_FontDataHashes.find(src->FontData);
+		if (it == s_FontDataHashes.end())
+			it = s_FontDataHashes.emplace(src->FontData, HashBytes(src->FontData, (size_t)src->FontDataSize)).first;
+
+		uint64_t hash = it->second;
+		hash = HashValue(src->FontNo, hash);
+		hash = HashValue(src->OversampleH, hash);
+		hash = HashValue(src->OversampleV, hash);
+		hash = HashValue(src->PixelSnapH, hash);
+		hash = HashValue(src->PixelSnapV, hash);
+		hash = HashValue(src->GlyphOffset, hash);
+		hash = HashValue(src->RasterizerMultiply, hash);
+		hash = HashValue(src->RasterizerDensity, hash);
+		hash = HashValue(src->FontLoaderFlags, hash);
+		hash = HashValue(atlas->FontLoaderFlags, hash);
+		hash = HashValue(baked->OwnerFont->Sources[0]->SizePixels, hash);
+		hash = HashValue(baked->Size, hash);
+		hash = HashValue(baked->RasterizerDensity, hash);
+		hash = HashValue(codepoint, hash);
+		return hash;
+	}
+
+	static bool LoaderInit(ImFontAtlas* atlas)
+	{
+		return s_InnerLoader->LoaderInit ? s_InnerLoader->LoaderInit(atlas) : true;
+	}
+
+	static void LoaderShutdown(ImFontAtlas* atlas)
+	{
+		if (s_InnerLoader->LoaderShutdown)
+			s_InnerLoader->LoaderShutdown(atlas);
+	}
+
+	static bool FontSrcInit(ImFontAtlas* atlas, ImFontConfig* src)
+	{
+		return s_InnerLoader->FontSrcInit ? s_InnerLoader->FontSrcInit(atlas, src) : true;
+	}
+
+	static void FontSrcDestroy(ImFontAtlas* atlas, ImFontConfig* src)
+	{
+		s_FontDataHashes.erase(src->FontData);
+		if (s_InnerLoader->FontSrcDestroy)
+			s_InnerLoader->FontSrcDestroy(atlas, src);
+	}
+
+	static bool FontSrcContainsGlyph(ImFontAtlas* atlas, ImFontConfig* src, ImWchar codepoint)
+	{
+		return s_InnerLoader->FontSrcContainsGlyph(atlas, src, codepoint);
+	}
+
+	static bool FontBakedInit(ImFontAtlas* atlas, ImFontConfig* src, ImFontBaked* baked, void* loaderData)
+	{
+		return s_InnerLoader->FontBakedInit ? s_InnerLoader->FontBakedInit(atlas, src, baked, loaderData) : true;
+	}
+
+	static void FontBakedDestroy(ImFontAtlas* atlas, ImFontConfig* src, ImFontBaked* baked, void* loaderData)
+	{
+		if (s_InnerLoader->FontBakedDestroy)
+			s_InnerLoader->FontBakedDestroy(atlas, src, baked, loaderData);
+	}
+
+	static bool FontBakedLoadGlyph(ImFontAtlas* atlas, ImFontConfig* src, ImFontBaked* baked, void* loaderData, ImWchar codepoint, ImFontGlyph* outGlyph, float* outAdvanceX)
+	{
+		// Metrics only, no rasterization to save
+		ImTextureData* tex = atlas->TexData;
+		const bool cacheable = outAdvanceX == nullptr && (tex->Format == ImTextureFormat_RGBA32 || tex->Format == ImTextureFormat_Alpha8);
+		if (!cacheable)
+			return s_InnerLoader->FontBakedLoadGlyph(atlas, src, baked, loaderData, codepoint, outGlyph, outAdvanceX);
+
+		const uint64_t key = GetGlyphKey(atlas, src, baked, codepoint);
+
+		auto it = s_Glyphs.find(key);
+		if (it != s_Glyphs.end())
+		{
+			const GlyphEntry& entry = it->second;
+			ImFontAtlasRectId packID = ImFontAtlasPackAddRect(atlas, entry.Width, entry.Height);
+			if (packID == ImFontAtlasRectId_Invalid)
+				return false;
+
+			// The tex pointer may have changed if the atlas grew
+			tex = atlas->TexData;
+			ImTextureRect* r = ImFontAtlasPackGetRect(atlas, packID);
+
+			outGlyph->Codepoint = codepoint;
+			outGlyph->AdvanceX = entry.AdvanceX;
+			outGlyph->X0 = entry.X0;
+			outGlyph->Y0 = entry.Y0;
+			outGlyph->X1 = entry.X1;
+			outGlyph->Y1 = entry.Y1;
+			outGlyph->Visible = true;
+			outGlyph->PackId = packID;
+
+			// Cached pixels are already post-processed
+			ImFontAtlasTextureBlockConvert(s_Pixels.data() + entry.PixelOffset, ImTextureFormat_Alpha8, entry.Width,
+				(unsigned char*)tex->GetPixelsAt(r->x, r->y), tex->Format, tex->GetPitch(), r->w, r->h);
+			ImFontAtlasTextureBlockQueueUpload(atlas, tex, r->x, r->y, r->w, r->h);
+			return true;
+		}
+
+		if (!s_InnerLoader->FontBakedLoadGlyph(atlas, src, baked, loaderData, codepoint, outGlyph, outAdvanceX))
+			return false;
+
+		// Glyphs without pixels are cheap to load, and coloured ones can't be stored as alpha
+		if (!outGlyph->Visible || outGlyph->Colored || outGlyph->PackId == ImFontAtlasRectId_Invalid)
+			return true;
+
+		tex = atlas->TexData;
+		ImTextureRect* r = ImFontAtlasPackGetRect(atlas, outGlyph->PackId);
+		const size_t size = (size_t)r->w * r->h;
+		if (s_Pixels.size() + size > s_MaxPixelsSize)
+			return true;
+
+		GlyphEntry entry;
+		entry.X0 = outGlyph->X0;
+		entry.Y0 = outGlyph->Y0;
+		entry.X1 = outGlyph->X1;
+		entry.Y1 = outGlyph->Y1;
+		entry.AdvanceX = outGlyph->AdvanceX;
+		entry.Width = r->w;
+		entry.Height = r->h;
+		entry.PixelOffset = (uint32_t)s_Pixels.size();
+
+		// Read back the alpha the loader just wrote into the atlas
+		const int bytesPerPixel = tex->BytesPerPixel;
+		const int alphaOffset = tex->Format == ImTextureFormat_RGBA32 ? 3 : 0;
+		s_Pixels.resize(s_Pixels.size() + size);
+		uint8_t* dst = s_Pixels.data() + entry.PixelOffset;
+		for (int y = 0; y < r->h; y++)
+		{
+			const uint8_t* src = (const uint8_t*)tex->GetPixelsAt(r->x, r->y + y);
+			for (int x = 0; x < r->w; x++)
+				*dst++ = src[x * bytesPerPixel + alphaOffset];
+		}
+
+		s_Glyphs.emplace(key, entry);
+		s_Dirty = true;
+		return true;
+	}
+
+	static void Load()
+	{
+		// Use the file Preload read if it is the same one
+		std::optional<CacheFile> file;
+		if (s_PreloadedFilepath == s_Filepath)
+			file = std::move(s_PreloadedFile);
+		else
+			file = ReadCacheFile(s_Filepath);
+
+		s_PreloadedFilepath.clear();
+		s_PreloadedFile.reset();
+
+		if (!file || file->LoaderHash != GetLoaderHash())
+			return;
+
+		s_Glyphs.reserve(file->Glyphs.size());
+		for (const FileGlyph& glyph : file->Glyphs)
+			s_Glyphs.emplace(glyph.Key, glyph.Glyph);
+		s_Pixels = std::move(file->Pixels);
+	}
+
+	void FontCache::Preload(const std::filesystem::path& filepath)
+	{
+		s_PreloadedFile = ReadCacheFile(filepath);
+		s_PreloadedFilepath = filepath;
+	}
+
+	void FontCache::Init(ImFontAtlas* atlas, const std::filesystem::path& filepath)
+	{
+		s_InnerLoader = atlas->FontLoader;
+		if (!s_InnerLoader)
+		{
+#ifdef IMGUI_ENABLE_FREETYPE
+			s_InnerLoader = ImGuiFreeType::GetFontLoader();
+#else
+			s_InnerLoader = ImFontAtlasGetFontLoaderForStbTruetype();
+#endif
+		}
+
+		s_LoaderName = std::string(s_InnerLoader->Name) + " (cached)";
+		s_Loader.Name = s_LoaderName.c_str();
+		s_Loader.LoaderInit = LoaderInit;
+		s_Loader.LoaderShutdown = LoaderShutdown;
+		s_Loader.FontSrcInit = FontSrcInit;
+		s_Loader.FontSrcDestroy = FontSrcDestroy;
+		s_Loader.FontSrcContainsGlyph = FontSrcContainsGlyph;
+		s_Loader.FontBakedInit = FontBakedInit;
+		s_Loader.FontBakedDestroy = FontBakedDestroy;
+		s_Loader.FontBakedLoadGlyph = FontBakedLoadGlyph;
+		s_Loader.FontBakedSrcLoaderDataSize = s_InnerLoader->FontBakedSrcLoaderDataSize;
+
+		s_Filepath = filepath;
+		if (!s_Filepath.empty())
+			Load();
+		s_Dirty = false;
+
+		atlas->SetFontLoader(&s_Loader);
+	}
+
+	void FontCache::Shutdown()
+	{
+		if (s_Dirty)
+			Save();
+
+		s_Glyphs.clear();
+		s_Pixels = {};
+		s_Dirty = false;
+	}
+
+	bool FontCache::Save()
+	{
+		if (s_Filepath.empty())
+			return false;
+
+		std::vector<FileGlyph> glyphs;
+		glyphs.reserve(s_Glyphs.size());
+		for (const auto& [key, glyph] : s_Glyphs)
+			glyphs.push_back({ key, glyph });
+
+		FileHeader header;
+		header.GlyphCount = (uint32_t)glyphs.size();
+		header.LoaderHash = GetLoaderHash();
+		header.PixelsSize = s_Pixels.size();
+		header.DataHash = HashBytes(glyphs.data(), glyphs.size() * sizeof(FileGlyph));
+		header.DataHash = HashBytes(s_Pixels.data(), s_Pixels.size(), header.DataHash);
+
+		std::error_code error;
+		std::filesystem::create_directories(s_Filepath.parent_path(), error);
+
+		// Written next to the cache and moved over it, so a crash never leaves a half-written file behind
+		std::filesystem::path tempFilepath = s_Filepath;
+		tempFilepath += ".tmp";
+		{
+			std::ofstream stream(tempFilepath, std::ios::binary | std::ios::trunc);
+			stream.write((const char*)&header, sizeof(FileHeader));
+			stream.write((const char*)glyphs.data(), (std::streamsize)(glyphs.size() * sizeof(FileGlyph)));
+			stream.write((const char*)s_Pixels.data(), (std::streamsize)s_Pixels.size());
+			if (!stream)
+			{
+				WL_CORE_WARN_TAG("UI", "Failed to write font cache {}", tempFilepath.string());
+				return false;
+			}
+		}
+
+		std::filesystem::rename(tempFilepath, s_Filepath, error);
+		if (error)
+		{
+			WL_CORE_WARN_TAG("UI", "Failed to save font cache {}: {}", s_Filepath.string(), error.message());
+			std::filesystem::remove(tempFilepath, error);
+			return false;
+		}
+
+		s_Dirty = false;
+		return true;
+	}
+
+	uint32_t FontCache::GetGlyphCount()
+	{
+		return (uint32_t)s_Glyphs.size();
+	}
+
+}
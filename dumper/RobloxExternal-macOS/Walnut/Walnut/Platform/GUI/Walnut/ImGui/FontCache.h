@@ -0,0 +1,34 @@
+#pragma once
+
+#include <imgui.h>
+
+#include <filesystem>
+
+namespace Walnut::UI {
+
+	//
+	// Persistent cache of rasterized glyphs, so text shown in earlier runs doesn't go
+	// through the font rasterizer again. It wraps the atlas' font loader: ImGui still
+	// bakes glyphs lazily, the first time a font is used at a given size, and cache hits
+	// are copied into the atlas instead of being rasterized.
+	// Glyphs are keyed by the font data, face, size, rasterizer density (DPI) and
+	// rasterizer settings, and the whole file is dropped when the ImGui version or the
+	// underlying loader changes. Main thread only, except Preload.
+	//
+	class FontCache
+	{
+	public:
+		// Call before adding fonts to the atlas. An empty filepath caches in memory only.
+		static void Init(ImFontAtlas* atlas, const std::filesystem::path& filepath);
+		// Reads the cache file ahead of Init, from any thread (e.g. a job while the device is created).
+		// Must finish before Init, which then skips the file I/O.
+		static void Preload(const std::filesystem::path& filepath);
+		// Saves newly rasterized glyphs, call before the ImGui context is destroyed
+		static void Shutdown();
+
+		static bool Save();
+
+		static uint32_t GetGlyphCount();
+	};
+
+}
@@ -4,6 +4,12 @@
 #include "backends/imgui_impl_vulkan.h"
 
 #include "ApplicationGUI.h"
+#include "Vulkan/DeletionQueue.h"
+#include "Vulkan/SamplerCache.h"
+#include "Vulkan/UploadQueue.h"
+
+#include "Walnut/Core/Assert.h"
+#include "Walnut/Core/Log.h"
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
@@ -12,19 +18,6 @@ namespace Walnut {
 
 	namespace Utils {
 
-		static uint32_t GetVulkanMemoryType(VkMemoryPropertyFlags properties, uint32_t type_bits)
-		{
-			VkPhysicalDeviceMemoryProperties prop;
-			vkGetPhysicalDeviceMemoryProperties(Application::GetPhysicalDevice(), &prop);
-			for (uint32_t i = 0; i < prop.memoryTypeCount; i++)
-			{
-				if ((prop.memoryTypes[i].propertyFlags & properties) == properties && type_bits & (1 << i))
-					return i;
-			}
-			
-			return 0xffffffff;
-		}
-
 		static uint32_t BytesPerPixel(ImageFormat format)
 		{
 			switch (format)
@@ -111,16 +104,16 @@ namespace Walnut {
 			info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
 			err = vkCreateImage(device, &info, nullptr, &m_Image);
 			check_vk_result(err);
-			VkMemoryRequirements req;
-			vkGetImageMemoryRequirements(device, m_Image, &req);
-			VkMemoryAllocateInfo alloc_info = {};
-			alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-			alloc_info.allocationSize = req.size;
-			alloc_info.memoryTypeIndex = Utils::GetVulkanMemoryType(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, req.memoryTypeBits);
-			err = vkAllocateMemory(device, &alloc_info, nullptr, &m_Memory);
-			check_vk_result(err);
-			err = vkBindImageMemory(device, m_Image, m_Memory, 0);
-			check_vk_result(err);
+			m_Allocation = MemoryAllocator::AllocateImage(m_Image, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+			// Out of device memory: the image stays empty rather than getting a view and uploads without memory
+			if (!m_Allocation.IsValid())
+			{
+				WL_CORE_ERROR_TAG("Renderer", "Failed to allocate memory for a {}x{} image", m_Width, m_Height);
+				vkDestroyImage(device, m_Image, nullptr);
+				m_Image = nullptr;
+				return;
+			}
 		}
 
 		// Create the Image View:
@@ -137,22 +130,8 @@ namespace Walnut {
 			check_vk_result(err);
 		}
 
-		// Create sampler:
-		{
-			VkSamplerCreateInfo info = {};
-			info.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
-			info.magFilter = VK_FILTER_LINEAR;
-			info.minFilter = VK_FILTER_LINEAR;
-			info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
-			info.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-			info.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-			info.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-			info.minLod = -1000;
-			info.maxLod = 1000;
-			info.maxAnisotropy = 1.0f;
-			VkResult err = vkCreateSampler(device, &info, nullptr, &m_Sampler);
-			check_vk_result(err);
-		}
+		// Samplers are shared between images
+		m_Sampler = SamplerCache::Get(VK_FILTER_LINEAR, VK_SAMPLER_ADDRESS_MODE_REPEAT);
 
 		// Create the Descriptor Set:
 		m_DescriptorSet = (VkDescriptorSet)ImGui_ImplVulkan_AddTexture(m_Sampler, m_ImageView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
@@ -160,118 +139,88 @@ namespace Walnut {
 
 	void Image::Release()
 	{
-		Application::SubmitResourceFree([sampler = m_Sampler, imageView = m_ImageView, image = m_Image,
-			memory = m_Memory, stagingBuffer = m_StagingBuffer, stagingBufferMemory = m_StagingBufferMemory]()
-		{
-			VkDevice device = Application::GetDevice();
-
-			vkDestroySampler(device, sampler, nullptr);
-			vkDestroyImageView(device, imageView, nullptr);
-			vkDestroyImage(device, image, nullptr);
-			vkFreeMemory(device, memory, nullptr);
-			vkDestroyBuffer(device, stagingBuffer, nullptr);
-			vkFreeMemory(device, stagingBufferMemory, nullptr);
-		});
+		// Destroyed once the GPU is done with the frames that may still sample the image
+		DeletionQueue::ReleaseTexture(m_DescriptorSet);
+		DeletionQueue::ReleaseImageView(m_ImageView);
+		DeletionQueue::ReleaseImage(m_Image);
+		DeletionQueue::ReleaseMemory(m_Allocation);
 
+		m_DescriptorSet = nullptr;
 		m_Sampler = nullptr;
 		m_ImageView = nullptr;
 		m_Image = nullptr;
-		m_Memory = nullptr;
-		m_StagingBuffer = nullptr;
-		m_StagingBufferMemory = nullptr;
+		m_Allocation = {};
 	}
 
 	void Image::SetData(const void* data)
 	{
-		VkDevice device = Application::GetDevice();
+		const size_t uploadSize = (size_t)m_Width * m_Height * Utils::BytesPerPixel(m_Format);
+		if (void* dst = MapData())
+			memcpy(dst, data, uploadSize);
+	}
 
-		size_t upload_size = m_Width * m_Height * Utils::BytesPerPixel(m_Format);
+	void Image::SetData(const ImageRegion& region, const void* data, uint32_t stride)
+	{
+		const size_t rowSize = (size_t)region.Width * Utils::BytesPerPixel(m_Format);
+		if (stride == 0)
+			stride = (uint32_t)rowSize;
 
-		VkResult err;
+		uint8_t* dst = (uint8_t*)MapData(region);
+		if (!dst)
+			return;
 
-		if (!m_StagingBuffer)
+		const uint8_t* src = (const uint8_t*)data;
+		if (stride == rowSize)
 		{
-			// Create the Upload Buffer
-			{
-				VkBufferCreateInfo buffer_info = {};
-				buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-				buffer_info.size = upload_size;
-				buffer_info.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-				buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-				err = vkCreateBuffer(device, &buffer_info, nullptr, &m_StagingBuffer);
-				check_vk_result(err);
-				VkMemoryRequirements req;
-				vkGetBufferMemoryRequirements(device, m_StagingBuffer, &req);
-				m_AlignedSize = req.size;
-				VkMemoryAllocateInfo alloc_info = {};
-				alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-				alloc_info.allocationSize = req.size;
-				alloc_info.memoryTypeIndex = Utils::GetVulkanMemoryType(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, req.memoryTypeBits);
-				err = vkAllocateMemory(device, &alloc_info, nullptr, &m_StagingBufferMemory);
-				check_vk_result(err);
-				err = vkBindBufferMemory(device, m_StagingBuffer, m_StagingBufferMemory, 0);
-				check_vk_result(err);
-			}
-
+			memcpy(dst, src, rowSize * region.Height);
+			return;
 		}
 
-		// Upload to Buffer
-		{
-			char* map = NULL;
-			err = vkMapMemory(device, m_StagingBufferMemory, 0, m_AlignedSize, 0, (void**)(&map));
-			check_vk_result(err);
-			memcpy(map, data, upload_size);
-			VkMappedMemoryRange range[1] = {};
-			range[0].sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-			range[0].memory = m_StagingBufferMemory;
-			range[0].size = m_AlignedSize;
-			err = vkFlushMappedMemoryRanges(device, 1, range);
-			check_vk_result(err);
-			vkUnmapMemory(device, m_StagingBufferMemory);
-		}
+		for (uint32_t y = 0; y < region.Height; y++)
+			memcpy(dst + y * rowSize, src + (size_t)y * stride, rowSize);
+	}
+
+	void* Image::MapData(const ImageRegion& region)
+	{
+		return QueueUpload(region);
+	}
+
+	void* Image::MapData()
+	{
+		return QueueUpload({ 0, 0, m_Width, m_Height });
+	}
 
+	void* Image::QueueUpload(const ImageRegion& region)
+	{
+		WL_CORE_ASSERT(region.X + region.Width <= m_Width && region.Y + region.Height <= m_Height, "Image region out of bounds");
+		if (!m_Image || region.Width == 0 || region.Height == 0)
+			return nullptr;
+
+		const size_t uploadSize = (size_t)region.Width * region.Height * Utils::BytesPerPixel(m_Format);
 
-		// Copy to Image
+		// The caller writes into the staging ring directly, the GPU copy is recorded with the next frame
+		UploadQueue& uploadQueue = Application::GetUploadQueue();
+		StagingAllocation staging = uploadQueue.AllocateStaging(uploadSize);
+		if (!staging.IsValid())
 		{
-			VkCommandBuffer command_buffer = Application::GetCommandBuffer(true);
-
-			VkImageMemoryBarrier copy_barrier = {};
-			copy_barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-			copy_barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-			copy_barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-			copy_barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-			copy_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-			copy_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-			copy_barrier.image = m_Image;
-			copy_barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-			copy_barrier.subresourceRange.levelCount = 1;
-			copy_barrier.subresourceRange.layerCount = 1;
-			vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_HOST_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, NULL, 0, NULL, 1, &copy_barrier);
-
-			VkBufferImageCopy region = {};
-			region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-			region.imageSubresource.layerCount = 1;
-			region.imageExtent.width = m_Width;
-			region.imageExtent.height = m_Height;
-			region.imageExtent.depth = 1;
-			vkCmdCopyBufferToImage(command_buffer, m_StagingBuffer, m_Image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
-
-			VkImageMemoryBarrier use_barrier = {};
-			use_barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-			use_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-			use_barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-			use_barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-			use_barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-			use_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-			use_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-			use_barrier.image = m_Image;
-			use_barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-			use_barrier.subresourceRange.levelCount = 1;
-			use_barrier.subresourceRange.layerCount = 1;
-			vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, NULL, 0, NULL, 1, &use_barrier);
-
-			Application::FlushCommandBuffer(command_buffer);
+			WL_CORE_ERROR_TAG("Renderer", "Failed to allocate {} bytes of staging memory for an image upload", uploadSize);
+			return nullptr;
 		}
+
+		VkBufferImageCopy copy = {};
+		copy.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		copy.imageSubresource.layerCount = 1;
+		copy.imageOffset.x = (int32_t)region.X;
+		copy.imageOffset.y = (int32_t)region.Y;
+		copy.imageExtent.width = region.Width;
+		copy.imageExtent.height = region.Height;
+		copy.imageExtent.depth = 1;
+
+		const bool fullImage = region.X == 0 && region.Y == 0 && region.Width == m_Width && region.Height == m_Height;
+		uploadQueue.UploadToImage(staging, m_Image, &copy, 1, m_HasData && !fullImage);
+		m_HasData = true;
+
+		return staging.Data;
 	}
 
 	void Image::Resize(uint32_t width, uint32_t height)
@@ -286,6 +235,7 @@ namespace Walnut {
 
 		Release();
 		AllocateMemory(m_Width * m_Height * Utils::BytesPerPixel(m_Format));
+		m_HasData = false;
 	}
 
 	void* Image::Decode(const void* buffer, uint64_t length, uint32_t& outWidth, uint32_t& outHeight)
@@ -4,6 +4,8 @@
 
 #include "vulkan/vulkan.h"
 
+#include "Vulkan/MemoryAllocator.h"
+
 namespace Walnut {
 
 	enum class ImageFormat
@@ -13,14 +15,29 @@ namespace Walnut {
 		RGBA32F
 	};
 
+	struct ImageRegion
+	{
+		uint32_t X = 0, Y = 0;
+		uint32_t Width = 0, Height = 0;
+	};
+
 	class Image
 	{
 	public:
+		// Decodes on the calling thread, see ImageCache::Load to load in the background
 		Image(std::string_view path);
 		Image(uint32_t width, uint32_t height, ImageFormat format, const void* data = nullptr);
 		~Image();
 
+		// Doesn't block, the upload is recorded with the next frame
 		void SetData(const void* data);
+		// Only uploads region, stride is the distance between rows of data in bytes (0 = tightly packed)
+		void SetData(const ImageRegion& region, const void* data, uint32_t stride = 0);
+
+		// Returns staging memory to write the new pixels of region into directly, rows are tightly packed.
+		// Must be filled before the end of the current frame.
+		void* MapData(const ImageRegion& region);
+		void* MapData();
 
 		VkDescriptorSet GetDescriptorSet() const { return m_DescriptorSet; }
 
@@ -33,20 +50,20 @@ namespace Walnut {
 	private:
 		void AllocateMemory(uint64_t size);
 		void Release();
+
+		void* QueueUpload(const ImageRegion& region);
 	private:
 		uint32_t m_Width = 0, m_Height = 0;
 
 		VkImage m_Image = nullptr;
 		VkImageView m_ImageView = nullptr;
-		VkDeviceMemory m_Memory = nullptr;
+		MemoryAllocation m_Allocation;
 		VkSampler m_Sampler = nullptr;
 
 		ImageFormat m_Format = ImageFormat::None;
 
-		VkBuffer m_StagingBuffer = nullptr;
-		VkDeviceMemory m_StagingBufferMemory = nullptr;
-
-		size_t m_AlignedSize = 0;
+		// Partial uploads have to keep the rest of the image once it has contents
+		bool m_HasData = false;
 
 		VkDescriptorSet m_DescriptorSet = nullptr;
 
@@ -0,0 +1,101 @@
+#include "ImageAtlas.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace Walnut {
+
+	// Extruded border around every image
+	static constexpr uint32_t s_Padding = 1;
+
+	ImageAtlas::ImageAtlas(uint32_t pageSize)
+		: m_PageSize(pageSize)
+	{
+	}
+
+	AtlasImage ImageAtlas::Add(uint32_t width, uint32_t height, const void* data)
+	{
+		if (width == 0 || height == 0)
+			return {};
+
+		const uint32_t paddedWidth = width + s_Padding * 2;
+		const uint32_t paddedHeight = height + s_Padding * 2;
+
+		Page* page = nullptr;
+		uint32_t x = 0, y = 0;
+		for (Page& candidate : m_Pages)
+		{
+			if (Allocate(candidate, paddedWidth, paddedHeight, x, y))
+			{
+				page = &candidate;
+				break;
+			}
+		}
+
+		const bool newPage = !page;
+		if (newPage)
+		{
+			page = &m_Pages.emplace_back();
+			page->Width = std::max(m_PageSize, paddedWidth);
+			page->Height = std::max(m_PageSize, paddedHeight);
+			page->Texture = std::make_shared<Image>(page->Width, page->Height, ImageFormat::RGBA);
+			Allocate(*page, paddedWidth, paddedHeight, x, y);
+		}
+
+		// Written straight into staging memory, clamping the source coordinates extrudes the edges
+		uint32_t* dst = (uint32_t*)page->Texture->MapData({ x, y, paddedWidth, paddedHeight });
+		if (!dst)
+		{
+			// The page image or the staging memory failed to allocate, a failed page is retried next time
+			if (newPage)
+				m_Pages.pop_back();
+			return {};
+		}
+
+		const uint32_t* src = (const uint32_t*)data;
+		for (uint32_t row = 0; row < paddedHeight; row++)
+		{
+			const uint32_t srcRow = std::clamp<int32_t>((int32_t)row - (int32_t)s_Padding, 0, (int32_t)height - 1);
+			uint32_t* dstRow = dst + (size_t)row * paddedWidth;
+
+			dstRow[0] = src[(size_t)srcRow * width];
+			memcpy(dstRow + s_Padding, src + (size_t)srcRow * width, (size_t)width * 4);
+			dstRow[paddedWidth - 1] = src[(size_t)srcRow * width + width - 1];
+		}
+
+		AtlasImage image;
+		image.Page = page->Texture;
+		image.Width = width;
+		image.Height = height;
+		image.UV0 = { (float)(x + s_Padding) / page->Width, (float)(y + s_Padding) / page->Height };
+		image.UV1 = { (float)(x + s_Padding + width) / page->Width, (float)(y + s_Padding + height) / page->Height };
+		return image;
+	}
+
+	bool ImageAtlas::Allocate(Page& page, uint32_t width, uint32_t height, uint32_t& outX, uint32_t& outY)
+	{
+		uint32_t shelfY = page.ShelfY;
+		uint32_t shelfHeight = page.ShelfHeight;
+		uint32_t cursorX = page.CursorX;
+
+		// Start a new shelf when the current one is out of space
+		if (cursorX + width > page.Width)
+		{
+			shelfY += shelfHeight;
+			shelfHeight = 0;
+			cursorX = 0;
+		}
+
+		if (cursorX + width > page.Width || shelfY + height > page.Height)
+			return false;
+
+		outX = cursorX;
+		outY = shelfY;
+
+		page.ShelfY = shelfY;
+		page.ShelfHeight = std::max(shelfHeight, height);
+		page.CursorX = cursorX + width;
+		return true;
+	}
+
+}
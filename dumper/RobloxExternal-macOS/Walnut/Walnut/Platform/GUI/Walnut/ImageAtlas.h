@@ -0,0 +1,58 @@
+#pragma once
+
+#include "Image.h"
+
+#include "imgui.h"
+
+#include <memory>
+#include <vector>
+
+namespace Walnut {
+
+	// Sub-rectangle of an atlas page
+	struct AtlasImage
+	{
+		std::shared_ptr<Image> Page;
+		ImVec2 UV0 = { 0.0f, 0.0f };
+		ImVec2 UV1 = { 1.0f, 1.0f };
+		uint32_t Width = 0, Height = 0;
+
+		bool IsValid() const { return (bool)Page; }
+		VkDescriptorSet GetDescriptorSet() const { return Page->GetDescriptorSet(); }
+	};
+
+	//
+	// Packs small static RGBA images into shared pages, so icons drawn together
+	// share a texture and a descriptor set and don't break ImGui draw calls.
+	// Images are packed into shelves and their edges extruded by a pixel to keep
+	// linear filtering from bleeding in neighbours. Main thread only.
+	//
+	class ImageAtlas
+	{
+	public:
+		ImageAtlas(uint32_t pageSize = 1024);
+
+		// Tightly packed RGBA pixels, images that don't fit into a page get a page of their own
+		// Returns an invalid AtlasImage when GPU memory runs out
+		AtlasImage Add(uint32_t width, uint32_t height, const void* data);
+
+		uint32_t GetPageCount() const { return (uint32_t)m_Pages.size(); }
+	private:
+		struct Page
+		{
+			std::shared_ptr<Image> Texture;
+			uint32_t Width = 0, Height = 0;
+
+			// Current shelf, everything above ShelfY is full
+			uint32_t ShelfY = 0;
+			uint32_t ShelfHeight = 0;
+			uint32_t CursorX = 0;
+		};
+
+		bool Allocate(Page& page, uint32_t width, uint32_t height, uint32_t& outX, uint32_t& outY);
+	private:
+		uint32_t m_PageSize;
+		std::vector<Page> m_Pages;
+	};
+
+}
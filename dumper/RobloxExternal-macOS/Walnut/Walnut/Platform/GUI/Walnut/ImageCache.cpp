@@ -0,0 +1,272 @@
+#include "ImageCache.h"
+
+#include "ApplicationGUI.h"
+
+#include "Walnut/Core/Log.h"
+#include "Walnut/Core/Profiler.h"
+
+#include "stb_image.h"
+
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+namespace Walnut {
+
+	namespace {
+
+		struct DecodedImage
+		{
+			void* Pixels = nullptr;
+			uint32_t Width = 0, Height = 0;
+			ImageFormat Format = ImageFormat::None;
+
+			// stb_image keeps the failure reason per thread
+			const char* FailureReason = nullptr;
+
+			DecodedImage() = default;
+			DecodedImage(const DecodedImage&) = delete;
+			~DecodedImage() { stbi_image_free(Pixels); }
+		};
+
+		struct CacheEntry
+		{
+			std::shared_ptr<AsyncImage> Image;
+			std::list<std::string>::iterator LRUPosition;
+
+			// GPU memory, 0 until the image is ready
+			uint64_t MemorySize = 0;
+		};
+
+		// Front is the most recently used
+		std::list<std::string> s_LRU;
+		std::unordered_map<std::string, CacheEntry> s_Entries;
+
+		uint64_t s_MemoryUsage = 0;
+		uint64_t s_MemoryBudget = 256 * 1024 * 1024;
+
+		std::shared_ptr<Image> s_Placeholder;
+
+		void Decode(DecodedImage& image, const stbi_uc* buffer, int length)
+		{
+			WL_PROFILE_SCOPE("ImageCache::Decode");
+
+			int width, height, channels;
+			if (stbi_is_hdr_from_memory(buffer, length))
+			{
+				image.Pixels = stbi_loadf_from_memory(buffer, length, &width, &height, &channels, 4);
+				image.Format = ImageFormat::RGBA32F;
+			}
+			else
+			{
+				image.Pixels = stbi_load_from_memory(buffer, length, &width, &height, &channels, 4);
+				image.Format = ImageFormat::RGBA;
+			}
+
+			if (image.Pixels)
+			{
+				image.Width = width;
+				image.Height = height;
+			}
+			else
+			{
+				image.FailureReason = stbi_failure_reason();
+			}
+		}
+
+		void DecodeFile(DecodedImage& image, const std::filesystem::path& path)
+		{
+			WL_PROFILE_SCOPE("ImageCache::DecodeFile");
+
+			const std::string filepath = path.string();
+
+			int width, height, channels;
+			if (stbi_is_hdr(filepath.c_str()))
+			{
+				image.Pixels = stbi_loadf(filepath.c_str(), &width, &height, &channels, 4);
+				image.Format = ImageFormat::RGBA32F;
+			}
+			else
+			{
+				image.Pixels = stbi_load(filepath.c_str(), &width, &height, &channels, 4);
+				image.Format = ImageFormat::RGBA;
+			}
+
+			if (image.Pixels)
+			{
+				image.Width = width;
+				image.Height = height;
+			}
+			else
+			{
+				image.FailureReason = stbi_failure_reason();
+			}
+		}
+
+		uint64_t GetMemorySize(const DecodedImage& image)
+		{
+			const uint64_t bytesPerPixel = image.Format == ImageFormat::RGBA32F ? 16 : 4;
+			return (uint64_t)image.Width * image.Height * bytesPerPixel;
+		}
+
+		void Evict()
+		{
+			if (s_MemoryBudget == 0)
+				return;
+
+			// Images still held outside of the cache would stay in memory anyway
+			auto it = s_LRU.end();
+			while (s_MemoryUsage > s_MemoryBudget && it != s_LRU.begin())
+			{
+				--it;
+
+				auto entry = s_Entries.find(*it);
+				if (entry->second.MemorySize == 0 || entry->second.Image.use_count() > 1)
+					continue;
+
+				s_MemoryUsage -= entry->second.MemorySize;
+				s_Entries.erase(entry);
+				it = s_LRU.erase(it);
+			}
+		}
+
+	}
+
+	std::shared_ptr<AsyncImage> ImageCache::Find(const std::string& key)
+	{
+		auto it = s_Entries.find(key);
+		if (it == s_Entries.end())
+			return nullptr;
+
+		s_LRU.splice(s_LRU.begin(), s_LRU, it->second.LRUPosition);
+		return it->second.Image;
+	}
+
+	template<typename DecodeFunc>
+	std::shared_ptr<AsyncImage> ImageCache::LoadInternal(std::string key, DecodeFunc&& decode)
+	{
+		if (std::shared_ptr<AsyncImage> cached = Find(key))
+			return cached;
+
+		auto asyncImage = std::make_shared<AsyncImage>();
+
+		s_LRU.push_front(key);
+		CacheEntry& entry = s_Entries[key];
+		entry.Image = asyncImage;
+		entry.LRUPosition = s_LRU.begin();
+
+		auto decoded = std::make_shared<DecodedImage>();
+
+		JobSystem& jobSystem = Application::Get().GetJobSystem();
+		JobHandle decodeJob = jobSystem.Submit([decoded, decode = std::forward<DecodeFunc>(decode)]()
+		{
+			decode(*decoded);
+		});
+
+		// Creating the Image has to happen on the main thread, the upload itself doesn't block
+		jobSystem.SubmitMainThread([asyncImage, decoded, key = std::move(key)]()
+		{
+			if (!decoded->Pixels)
+			{
+				WL_CORE_ERROR("Failed to decode image {}: {}", key, decoded->FailureReason ? decoded->FailureReason : "unknown error");
+				asyncImage->m_Failed = true;
+
+				// Not cached, so a later Load tries again (the file may exist by then)
+				auto it = s_Entries.find(key);
+				if (it != s_Entries.end() && it->second.Image == asyncImage)
+				{
+					s_LRU.erase(it->second.LRUPosition);
+					s_Entries.erase(it);
+				}
+				return;
+			}
+
+			asyncImage->m_Image = std::make_shared<Image>(decoded->Width, decoded->Height, decoded->Format, decoded->Pixels);
+
+			// The entry may have been cleared while decoding
+			auto it = s_Entries.find(key);
+			if (it == s_Entries.end() || it->second.Image != asyncImage)
+				return;
+
+			it->second.MemorySize = GetMemorySize(*decoded);
+			s_MemoryUsage += it->second.MemorySize;
+			Evict();
+		}, { decodeJob });
+
+		return asyncImage;
+	}
+
+	const std::shared_ptr<Image>& AsyncImage::GetImage() const
+	{
+		return m_Image ? m_Image : ImageCache::GetPlaceholder();
+	}
+
+	std::shared_ptr<AsyncImage> ImageCache::Load(const std::filesystem::path& path)
+	{
+		std::error_code error;
+		std::filesystem::path canonicalPath = std::filesystem::weakly_canonical(path, error);
+		if (error)
+			canonicalPath = path;
+
+		return LoadInternal("file:" + canonicalPath.string(), [canonicalPath](DecodedImage& image)
+		{
+			DecodeFile(image, canonicalPath);
+		});
+	}
+
+	std::shared_ptr<AsyncImage> ImageCache::Load(const void* data, uint64_t size)
+	{
+		// FNV-1a, identical contents share an image no matter where they came from
+		uint64_t hash = 14695981039346656037ull;
+		const uint8_t* bytes = (const uint8_t*)data;
+		for (uint64_t i = 0; i < size; i++)
+			hash = (hash ^ bytes[i]) * 1099511628211ull;
+
+		std::string key = "data:" + std::to_string(hash) + ":" + std::to_string(size);
+		if (std::shared_ptr<AsyncImage> cached = Find(key))
+			return cached;
+
+		// Only copied on a miss, the decode job outlives the caller's buffer
+		std::vector<uint8_t> buffer(bytes, bytes + size);
+		return LoadInternal(std::move(key), [buffer = std::move(buffer)](DecodedImage& image)
+		{
+			Decode(image, buffer.data(), (int)buffer.size());
+		});
+	}
+
+	void ImageCache::SetMemoryBudget(uint64_t budget)
+	{
+		s_MemoryBudget = budget;
+		Evict();
+	}
+
+	uint64_t ImageCache::GetMemoryBudget()
+	{
+		return s_MemoryBudget;
+	}
+
+	uint64_t ImageCache::GetMemoryUsage()
+	{
+		return s_MemoryUsage;
+	}
+
+	const std::shared_ptr<Image>& ImageCache::GetPlaceholder()
+	{
+		if (!s_Placeholder)
+		{
+			const uint32_t pixel = 0xff404040;
+			s_Placeholder = std::make_shared<Image>(1, 1, ImageFormat::RGBA, &pixel);
+		}
+
+		return s_Placeholder;
+	}
+
+	void ImageCache::Clear()
+	{
+		s_Entries.clear();
+		s_LRU.clear();
+		s_MemoryUsage = 0;
+		s_Placeholder.reset();
+	}
+
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "Image.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+
+namespace Walnut {
+
+	// Image that is decoded in the background, shows a placeholder until it is ready.
+	// Main thread only.
+	class AsyncImage
+	{
+	public:
+		bool IsReady() const { return (bool)m_Image; }
+		bool HasFailed() const { return m_Failed; }
+
+		// Placeholder until the image is ready
+		const std::shared_ptr<Image>& GetImage() const;
+
+		VkDescriptorSet GetDescriptorSet() const { return GetImage()->GetDescriptorSet(); }
+		uint32_t GetWidth() const { return GetImage()->GetWidth(); }
+		uint32_t GetHeight() const { return GetImage()->GetHeight(); }
+	private:
+		std::shared_ptr<Image> m_Image;
+		bool m_Failed = false;
+
+		friend class ImageCache;
+	};
+
+	//
+	// Decodes images on the JobSystem workers and shares them between everyone loading
+	// the same file or contents. Images nobody else holds on to are evicted least recently
+	// used first once the cache uses more GPU memory than its budget. Main thread only.
+	//
+	class ImageCache
+	{
+	public:
+		static std::shared_ptr<AsyncImage> Load(const std::filesystem::path& path);
+
+		// Encoded image file contents, copied so data doesn't have to outlive the call
+		static std::shared_ptr<AsyncImage> Load(const void* data, uint64_t size);
+
+		// In bytes, 0 = no eviction
+		static void SetMemoryBudget(uint64_t budget);
+		static uint64_t GetMemoryBudget();
+		static uint64_t GetMemoryUsage();
+
+		static const std::shared_ptr<Image>& GetPlaceholder();
+
+		// Called by the Application before the renderer shuts down
+		static void Clear();
+	private:
+		template<typename DecodeFunc>
+		static std::shared_ptr<AsyncImage> LoadInternal(std::string key, DecodeFunc&& decode);
+		// Marks the entry as most recently used, nullptr if the key isn't cached
+		static std::shared_ptr<AsyncImage> Find(const std::string& key);
+	};
+
+}
@@ -4,20 +4,174 @@
 
 #include "misc/cpp/imgui_stdlib.h"
 
+#include <algorithm>
+
 namespace Walnut::UI {
 
-	Console::Console(std::string_view title)
-		: m_Title(title)
+	Console::Console(std::string_view title, uint32_t capacity)
+		: m_Title(title), m_Capacity(std::max(capacity, 1u)), m_PendingCapacity(m_Capacity)
+	{
+	}
+
+	Console::~Console()
+	{
+		PendingMessage* message = m_PendingMessages.exchange(nullptr, std::memory_order_acquire);
+		while (message)
+		{
+			PendingMessage* next = message->Next;
+			delete message;
+			message = next;
+		}
+	}
+
+	void Console::Enqueue(MessageInfo&& message)
+	{
+		// Bounded while the console isn't drawn, like the ring buffer itself
+		if (m_PendingCount.fetch_add(1, std::memory_order_relaxed) >= m_PendingCapacity.load(std::memory_order_relaxed))
+		{
+			m_PendingCount.fetch_sub(1, std::memory_order_relaxed);
+			m_DroppedCount.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+
+		PendingMessage* node = new PendingMessage{ std::move(message), nullptr };
+
+		PendingMessage* head = m_PendingMessages.load(std::memory_order_relaxed);
+		do
+		{
+			node->Next = head;
+		} while (!m_PendingMessages.compare_exchange_weak(head, node, std::memory_order_release, std::memory_order_relaxed));
+
+		// First message of the batch, make sure a frame picks it up.
+		// Loggers keep running while there is no application (shutdown, soft restart).
+		if (!head)
+		{
+			if (Application* application = Application::TryGet())
+				application->RequestRedraw();
+		}
+	}
+
+	void Console::ProcessPendingMessages()
 	{
+		PendingMessage* message = m_PendingMessages.exchange(nullptr, std::memory_order_acquire);
+		if (!message)
+			return;
+
+		// Back to the order the messages were added in
+		PendingMessage* ordered = nullptr;
+		while (message)
+		{
+			PendingMessage* next = message->Next;
+			message->Next = ordered;
+			ordered = message;
+			message = next;
+		}
+
+		uint32_t count = 0;
+		while (ordered)
+		{
+			PendingMessage* next = ordered->Next;
+			PushMessage(std::move(ordered->Message));
+			delete ordered;
+			ordered = next;
+			count++;
+		}
+		m_PendingCount.fetch_sub(count, std::memory_order_relaxed);
+
+		if (const uint32_t dropped = m_DroppedCount.exchange(0, std::memory_order_relaxed))
+		{
+			MessageInfo info(std::format("{} messages dropped while the console wasn't drawn", dropped));
+			info.Italic = true;
+			PushMessage(std::move(info));
+		}
 	}
 
 	void Console::ClearLog()
 	{
-		m_MessageHistory.clear();
+		m_Messages.clear();
+		m_Head = 0;
+		m_FirstSequence += m_MessageCount;
+		m_MessageCount = 0;
+		m_FilteredMessages.clear();
+	}
+
+	void Console::SetCapacity(uint32_t capacity)
+	{
+		capacity = std::max(capacity, 1u);
+		if (capacity == m_Capacity)
+			return;
+
+		// Keep the newest messages, reordered so the oldest one is at the front again
+		const uint32_t keep = std::min(m_MessageCount, capacity);
+		const uint64_t lastSequence = m_FirstSequence + m_MessageCount;
+
+		std::vector<MessageInfo> messages;
+		messages.reserve(keep);
+		for (uint64_t sequence = lastSequence - keep; sequence < lastSequence; sequence++)
+			messages.push_back(std::move(m_Messages[GetMessageIndex(sequence)]));
+
+		m_Messages = std::move(messages);
+		m_Head = 0;
+		m_FirstSequence = lastSequence - keep;
+		m_MessageCount = keep;
+		m_Capacity = capacity;
+		m_PendingCapacity.store(capacity, std::memory_order_relaxed);
+
+		while (!m_FilteredMessages.empty() && m_FilteredMessages.front() < m_FirstSequence)
+			m_FilteredMessages.pop_front();
+	}
+
+	void Console::PushMessage(MessageInfo&& message)
+	{
+		const uint64_t sequence = m_FirstSequence + m_MessageCount;
+
+		if (m_MessageCount < m_Capacity)
+		{
+			m_Messages.push_back(std::move(message));
+			m_MessageCount++;
+		}
+		else
+		{
+			// Full, the newest message replaces the oldest one
+			m_Messages[m_Head] = std::move(message);
+			m_Head = (m_Head + 1) % m_Capacity;
+			m_FirstSequence++;
+
+			if (!m_FilteredMessages.empty() && m_FilteredMessages.front() < m_FirstSequence)
+				m_FilteredMessages.pop_front();
+		}
+
+		if (m_Filter.IsActive() && m_Filter.PassFilter(GetMessageInfo(sequence).Message.c_str()))
+			m_FilteredMessages.push_back(sequence);
+	}
+
+	uint32_t Console::GetMessageIndex(uint64_t sequence) const
+	{
+		return (uint32_t)((m_Head + (sequence - m_FirstSequence)) % m_Messages.size());
+	}
+
+	const Console::MessageInfo& Console::GetMessageInfo(uint64_t sequence) const
+	{
+		return m_Messages[GetMessageIndex(sequence)];
+	}
+
+	void Console::RebuildFilterIndex()
+	{
+		m_FilteredMessages.clear();
+		if (!m_Filter.IsActive())
+			return;
+
+		for (uint64_t sequence = m_FirstSequence; sequence < m_FirstSequence + m_MessageCount; sequence++)
+		{
+			if (m_Filter.PassFilter(GetMessageInfo(sequence).Message.c_str()))
+				m_FilteredMessages.push_back(sequence);
+		}
 	}
 
 	void Console::OnUIRender()
 	{
+		ProcessPendingMessages();
+
 		ImGui::SetNextWindowSize(ImVec2(520, 600), ImGuiCond_FirstUseEver);
 		if (!ImGui::Begin(m_Title.c_str()))
 		{
@@ -39,7 +193,8 @@ namespace Walnut::UI {
 		ImGui::SameLine();
 		ImGui::Text("Search");
 		ImGui::SameLine();
-		m_Filter.Draw("##search", 180);
+		if (m_Filter.Draw("##search", 180))
+			RebuildFilterIndex();
 		ImGui::Separator();
 
 		// Reserve enough left-over height for 1 separator + 1 input text
@@ -57,36 +212,40 @@ namespace Walnut::UI {
 
 		ImGui::SetCursorPosY(TextPadding);
 		ImGui::Dummy(ImVec2(0, 0));
-		for (int i = 0; i < m_MessageHistory.size(); i++)
+
+		// Only the visible rows are submitted, which assumes single-line messages
+		const bool filtered = m_Filter.IsActive();
+		ImGuiListClipper clipper;
+		clipper.Begin(filtered ? (int)m_FilteredMessages.size() : (int)m_MessageCount);
+		while (clipper.Step())
 		{
-			if (!m_Filter.PassFilter(m_MessageHistory[i].Message.c_str()))
-				continue;
+			for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; i++)
+			{
+				const MessageInfo& message = GetMessageInfo(filtered ? m_FilteredMessages[i] : m_FirstSequence + i);
 
-			ImGui::SetCursorPosX(TextPadding);
-			ImGui::Dummy(ImVec2(0, 0));
+				ImGui::SetCursorPosX(TextPadding);
 
-			// Normally you would store more information in your item than just a string.
-			// (e.g. make Items[] an array of structure, store color/type etc.)
-			ImGui::PushStyleColor(ImGuiCol_Text, ImColor(m_MessageHistory[i].Color).Value);
-			ImVec4 finalColor = ImColor(m_MessageHistory[i].Color).Value;
-			if (!m_MessageHistory[i].Tag.empty())
-			{
-				ImGui::PushFont(Application::GetFont("Bold"));
-				ImGui::TextUnformatted(m_MessageHistory[i].Tag.c_str());
-				ImGui::PopFont();
-				ImGui::SameLine(0.0f, TextPadding);
-			}
+				ImGui::PushStyleColor(ImGuiCol_Text, ImColor(message.Color).Value);
+				if (!message.Tag.empty())
+				{
+					ImGui::PushFont(Application::GetFont("Bold"));
+					ImGui::TextUnformatted(message.Tag.c_str());
+					ImGui::PopFont();
+					ImGui::SameLine(0.0f, TextPadding);
+				}
 
-			if (m_MessageHistory[i].Italic)
-				ImGui::PushFont(Application::GetFont("Italic"));
+				if (message.Italic)
+					ImGui::PushFont(Application::GetFont("Italic"));
 
-			ImGui::TextUnformatted(m_MessageHistory[i].Message.c_str());
+				ImGui::TextUnformatted(message.Message.c_str());
 
-			if (m_MessageHistory[i].Italic)
-				ImGui::PopFont();
+				if (message.Italic)
+					ImGui::PopFont();
 
-			ImGui::PopStyleColor();
+				ImGui::PopStyleColor();
+			}
 		}
+		clipper.End();
 
 		if (m_ScrollToBottom || (m_AutoScroll && ImGui::GetScrollY() >= ImGui::GetScrollMaxY()))
 			ImGui::SetScrollHereY(1.0f);
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <atomic>
+#include <deque>
 #include <vector>
 #include <string>
 #include <string_view>
@@ -10,61 +12,74 @@
 
 namespace Walnut::UI {
 
+	template<typename Mutex>
+	class ConsoleLogSink;
+
+	//
+	// The AddMessage functions are thread-safe: messages are formatted on the calling thread
+	// and handed to the UI thread through a lock-free list that OnUIRender drains once per frame.
+	// At most capacity messages wait in that list, further ones are dropped (and counted)
+	// until the console is drawn again. Everything else is UI thread only.
+	//
 	class Console
 	{
 	public:
 		using MessageSendCallback = std::function<void(std::string_view)>;
 	public:
-		Console(std::string_view title = "Walnut Console");
-		~Console() = default;
+		// Keeps the newest capacity messages, older ones are dropped
+		Console(std::string_view title = "Walnut Console", uint32_t capacity = 100000);
+		~Console();
 
 		void ClearLog();
 
+		void SetCapacity(uint32_t capacity);
+		uint32_t GetCapacity() const { return m_Capacity; }
+		uint32_t GetMessageCount() const { return m_MessageCount; }
+
 		template<typename... Args>
 		void AddMessage(std::string_view fmt, Args&&... args)
 		{
-			std::string s = std::format("Hello {}", "world");
 			std::string messageString = std::vformat(fmt, std::make_format_args(args...));
-			m_MessageHistory.push_back(messageString);
+			Enqueue(MessageInfo(std::move(messageString)));
 		}
 
 		template<typename... Args>
 		void AddItalicMessage(std::string_view fmt, Args&&... args)
 		{
 			std::string messageString = std::vformat(fmt, std::make_format_args(args...));
-			MessageInfo info = messageString;
+			MessageInfo info(std::move(messageString));
 			info.Italic = true;
-			m_MessageHistory.push_back(info);
+			Enqueue(std::move(info));
 		}
 		
 		template<typename... Args>
 		void AddTaggedMessage(std::string_view tag, std::string_view fmt, Args&&... args)
 		{
 			std::string messageString = std::vformat(fmt, std::make_format_args(args...));
-			m_MessageHistory.push_back(MessageInfo(std::string(tag), messageString));
+			Enqueue(MessageInfo(std::string(tag), std::move(messageString)));
 		}
 
 		template<typename... Args>
 		void AddMessageWithColor(uint32_t color, std::string_view fmt, Args&&... args)
 		{
 			std::string messageString = std::vformat(fmt, std::make_format_args(args...));
-			m_MessageHistory.push_back(MessageInfo(messageString, color));
+			Enqueue(MessageInfo(std::move(messageString), color));
 		}
 
 		template<typename... Args>
 		void AddItalicMessageWithColor(uint32_t color, std::string_view fmt, Args&&... args)
 		{
 			std::string messageString = std::vformat(fmt, std::make_format_args(args...));
-			MessageInfo info(messageString, color);
+			MessageInfo info(std::move(messageString), color);
 			info.Italic = true;
-			m_MessageHistory.push_back(info);
+			Enqueue(std::move(info));
 		}
 
 		template<typename... Args>
 		void AddTaggedMessageWithColor(uint32_t color, std::string_view tag, std::string_view fmt, Args&&... args)
 		{
 			std::string messageString = std::vformat(fmt, std::make_format_args(args...));
-			m_MessageHistory.push_back(MessageInfo(std::string(tag), messageString, color));
+			Enqueue(MessageInfo(std::string(tag), std::move(messageString), color));
 		}
 
 		void OnUIRender();
@@ -78,22 +93,62 @@ namespace Walnut::UI {
 			bool Italic = false;
 			uint32_t Color = 0xffffffff;
 
-			MessageInfo(const std::string& message, uint32_t color = 0xffffffff)
-				: Message(message), Color(color) {}
+			MessageInfo() = default;
+
+			MessageInfo(std::string message, uint32_t color = 0xffffffff)
+				: Message(std::move(message)), Color(color) {}
 
-			MessageInfo(const std::string& tag, const std::string& message, uint32_t color = 0xffffffff)
-				: Tag(tag), Message(message), Color(color) {}
+			MessageInfo(std::string tag, std::string message, uint32_t color = 0xffffffff)
+				: Tag(std::move(tag)), Message(std::move(message)), Color(color) {}
 		};
 
+		// Thread-safe, for callers that already have the final text (see ConsoleLogSink)
+		void Enqueue(MessageInfo&& message);
+
+		void ProcessPendingMessages();
+		void PushMessage(MessageInfo&& message);
+		uint32_t GetMessageIndex(uint64_t sequence) const;
+		const MessageInfo& GetMessageInfo(uint64_t sequence) const;
+		void RebuildFilterIndex();
+	private:
 		std::string m_Title;
 		std::string m_MessageBuffer;
-		std::vector<MessageInfo> m_MessageHistory;
+
+		// Ring buffer of the newest m_Capacity messages, the oldest one is at m_Head.
+		// Messages are addressed by sequence number (messages added before them),
+		// the oldest one kept is m_FirstSequence.
+		std::vector<MessageInfo> m_Messages;
+		uint32_t m_Capacity = 0;
+		uint32_t m_Head = 0;
+		uint32_t m_MessageCount = 0;
+		uint64_t m_FirstSequence = 0;
+
+		// Sequence numbers of the messages passing m_Filter, only kept up to date
+		// while the filter is active and rebuilt when the filter text changes
 		ImGuiTextFilter m_Filter;
+		std::deque<uint64_t> m_FilteredMessages;
+
 		bool m_AutoScroll = true;
 		bool m_ScrollToBottom = false;
 
 		MessageSendCallback m_MessageSendCallback;
 
+		struct PendingMessage
+		{
+			MessageInfo Message;
+			PendingMessage* Next;
+		};
+
+		// Messages added since the last frame, most recent first (see EventQueue)
+		std::atomic<PendingMessage*> m_PendingMessages = nullptr;
+		std::atomic<uint32_t> m_PendingCount = 0;
+		std::atomic<uint32_t> m_DroppedCount = 0;
+
+		// Copy of m_Capacity for the enqueuing threads
+		std::atomic<uint32_t> m_PendingCapacity = 0;
+
+		template<typename Mutex>
+		friend class ConsoleLogSink;
 	};
 
 }
\ No newline at end of file
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "Console.h"
+
+#include "spdlog/sinks/base_sink.h"
+#include "spdlog/details/null_mutex.h"
+
+#include <mutex>
+
+namespace Walnut::UI {
+
+	//
+	// spdlog sink feeding log output into a Console, attach it with Log::AddSink.
+	// The payload is taken as is rather than run through a formatter: the "[Tag] " prefix
+	// written by Log::PrintMessageTag becomes the message tag and the level picks the colour.
+	// Console ingestion is thread-safe, so the null mutex (_st) is enough for most uses.
+	// The Console must outlive the sink, detach it with Log::RemoveSink first.
+	//
+	template<typename Mutex>
+	class ConsoleLogSink final : public spdlog::sinks::base_sink<Mutex>
+	{
+	public:
+		ConsoleLogSink(Console& console)
+			: m_Console(console)
+		{
+		}
+	protected:
+		void sink_it_(const spdlog::details::log_msg& msg) override
+		{
+			std::string_view payload(msg.payload.data(), msg.payload.size());
+
+			Console::MessageInfo info;
+			if (payload.size() > 2 && payload[0] == '[')
+			{
+				size_t end = payload.find("] ");
+				if (end != std::string_view::npos)
+				{
+					info.Tag = payload.substr(1, end - 1);
+					payload.remove_prefix(end + 2);
+				}
+			}
+			info.Message = payload;
+			info.Color = LevelToColor(msg.level);
+
+			m_Console.Enqueue(std::move(info));
+		}
+
+		void flush_() override
+		{
+		}
+	private:
+		static uint32_t LevelToColor(spdlog::level::level_enum level)
+		{
+			switch (level)
+			{
+				case spdlog::level::trace:    return 0xff9e9e9e;
+				case spdlog::level::debug:    return 0xffc0c0c0;
+				case spdlog::level::info:     return 0xffffffff;
+				case spdlog::level::warn:     return 0xff3fc8ff;
+				case spdlog::level::err:      return 0xff4a4aff;
+				case spdlog::level::critical: return 0xff3030ff;
+				default: break;
+			}
+			return 0xffffffff;
+		}
+	private:
+		Console& m_Console;
+	};
+
+	using ConsoleLogSink_mt = ConsoleLogSink<std::mutex>;
+	using ConsoleLogSink_st = ConsoleLogSink<spdlog::details::null_mutex>;
+
+}
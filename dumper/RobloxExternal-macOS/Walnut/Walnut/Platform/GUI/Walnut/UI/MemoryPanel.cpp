@@ -0,0 +1,170 @@
+#include "MemoryPanel.h"
+
+#include "imgui.h"
+#include "misc/cpp/imgui_stdlib.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace Walnut::UI {
+
+	namespace Utils {
+
+		static void TextBytes(int64_t bytes)
+		{
+			const double absBytes = (double)(bytes < 0 ? -bytes : bytes);
+			if (absBytes >= 1024.0 * 1024.0 * 1024.0)
+				ImGui::Text("%.2f GB", bytes / (1024.0 * 1024.0 * 1024.0));
+			else if (absBytes >= 1024.0 * 1024.0)
+				ImGui::Text("%.2f MB", bytes / (1024.0 * 1024.0));
+			else if (absBytes >= 1024.0)
+				ImGui::Text("%.2f KB", bytes / 1024.0);
+			else
+				ImGui::Text("%lld B", (long long)bytes);
+		}
+
+	}
+
+	MemoryPanel::MemoryPanel(std::string_view title)
+		: m_Title(title)
+	{
+	}
+
+	void MemoryPanel::OnUIRender()
+	{
+		ImGui::SetNextWindowSize(ImVec2(800, 450), ImGuiCond_FirstUseEver);
+		if (!ImGui::Begin(m_Title.c_str()))
+		{
+			ImGui::End();
+			return;
+		}
+
+		if (!AllocationTracker::IsAvailable())
+		{
+			ImGui::TextWrapped("Allocation tracking is not compiled in, build with the WL_TRACK_ALLOCATIONS CMake option.");
+			ImGui::End();
+			return;
+		}
+
+		if (!m_Paused)
+			m_Stats = AllocationTracker::GetStats();
+
+		bool enabled = AllocationTracker::IsEnabled();
+		if (ImGui::Checkbox("Enabled", &enabled))
+			AllocationTracker::SetEnabled(enabled);
+
+		ImGui::SameLine();
+		ImGui::Checkbox("Paused", &m_Paused);
+
+		ImGui::SameLine();
+		if (ImGui::Button("Dump"))
+			AllocationTracker::DumpToFile(m_Stats, m_DumpPath);
+
+		ImGui::SameLine();
+		ImGui::SetNextItemWidth(240.0f);
+		ImGui::InputText("##DumpPath", &m_DumpPath);
+
+		ImGui::Separator();
+
+		const AllocationTagStats& total = m_Stats.Total;
+		ImGui::Text("Live:");
+		ImGui::SameLine();
+		Utils::TextBytes(total.LiveBytes);
+		ImGui::SameLine();
+		ImGui::Text("in %lld blocks  |  Last frame: %llu allocations,", (long long)total.LiveCount, (unsigned long long)total.FrameAllocations);
+		ImGui::SameLine();
+		Utils::TextBytes((int64_t)total.FrameBytes);
+		ImGui::SameLine();
+		ImGui::Text(" |  %.0f allocations/s", total.AllocationRate);
+
+		DrawFrameGraph();
+		DrawTagTable();
+
+		ImGui::End();
+	}
+
+	void MemoryPanel::DrawFrameGraph()
+	{
+		const std::vector<uint32_t>& history = m_Stats.FrameHistory;
+		if (history.empty())
+			return;
+
+		uint32_t maxAllocations = 1;
+		for (uint32_t allocations : history)
+			maxAllocations = std::max(maxAllocations, allocations);
+
+		auto getter = [](void* data, int index) -> float { return (float)(*(const std::vector<uint32_t>*)data)[index]; };
+		ImGui::PlotHistogram("##FrameAllocations", getter, (void*)&history, (int)history.size(), 0,
+			"Allocations per frame", 0.0f, (float)maxAllocations, ImVec2(ImGui::GetContentRegionAvail().x, 60.0f));
+	}
+
+	void MemoryPanel::DrawTagTable()
+	{
+		const ImGuiTableFlags flags = ImGuiTableFlags_Sortable | ImGuiTableFlags_RowBg | ImGuiTableFlags_Borders
+			| ImGuiTableFlags_Resizable | ImGuiTableFlags_ScrollY;
+		if (!ImGui::BeginTable("Tags", 7, flags))
+			return;
+
+		ImGui::TableSetupScrollFreeze(0, 1);
+		ImGui::TableSetupColumn("Tag", ImGuiTableColumnFlags_NoSort);
+		ImGui::TableSetupColumn("Live", ImGuiTableColumnFlags_DefaultSort | ImGuiTableColumnFlags_PreferSortDescending);
+		ImGui::TableSetupColumn("Live count", ImGuiTableColumnFlags_PreferSortDescending);
+		ImGui::TableSetupColumn("Frame allocations", ImGuiTableColumnFlags_PreferSortDescending);
+		ImGui::TableSetupColumn("Frame bytes", ImGuiTableColumnFlags_PreferSortDescending);
+		ImGui::TableSetupColumn("Allocations/s", ImGuiTableColumnFlags_PreferSortDescending);
+		ImGui::TableSetupColumn("Total allocations", ImGuiTableColumnFlags_PreferSortDescending);
+		ImGui::TableHeadersRow();
+
+		std::vector<const AllocationTagStats*> tags;
+		tags.reserve(m_Stats.Tags.size());
+		for (const AllocationTagStats& tag : m_Stats.Tags)
+			tags.push_back(&tag);
+
+		// Sorted every frame, the values change all the time anyway
+		if (const ImGuiTableSortSpecs* sortSpecs = ImGui::TableGetSortSpecs(); sortSpecs && sortSpecs->SpecsCount > 0)
+		{
+			const ImGuiTableColumnSortSpecs& spec = sortSpecs->Specs[0];
+			auto key = [column = spec.ColumnIndex](const AllocationTagStats* tag) -> double
+			{
+				switch (column)
+				{
+					case 1: return (double)tag->LiveBytes;
+					case 2: return (double)tag->LiveCount;
+					case 3: return (double)tag->FrameAllocations;
+					case 4: return (double)tag->FrameBytes;
+					case 5: return tag->AllocationRate;
+					case 6: return (double)tag->TotalAllocations;
+				}
+				return 0.0;
+			};
+
+			const bool ascending = spec.SortDirection == ImGuiSortDirection_Ascending;
+			std::stable_sort(tags.begin(), tags.end(), [&](const AllocationTagStats* a, const AllocationTagStats* b)
+			{
+				return ascending ? key(a) < key(b) : key(a) > key(b);
+			});
+		}
+
+		for (const AllocationTagStats* tag : tags)
+		{
+			ImGui::TableNextRow();
+			ImGui::TableNextColumn();
+			ImGui::TextUnformatted(tag->Name ? tag->Name : "");
+			ImGui::TableNextColumn();
+			Utils::TextBytes(tag->LiveBytes);
+			ImGui::TableNextColumn();
+			ImGui::Text("%lld", (long long)tag->LiveCount);
+			ImGui::TableNextColumn();
+			ImGui::Text("%llu", (unsigned long long)tag->FrameAllocations);
+			ImGui::TableNextColumn();
+			Utils::TextBytes((int64_t)tag->FrameBytes);
+			ImGui::TableNextColumn();
+			ImGui::Text("%.0f", tag->AllocationRate);
+			ImGui::TableNextColumn();
+			ImGui::Text("%llu", (unsigned long long)tag->TotalAllocations);
+		}
+
+		ImGui::EndTable();
+	}
+
+}
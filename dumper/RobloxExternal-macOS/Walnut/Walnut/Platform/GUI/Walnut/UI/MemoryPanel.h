@@ -0,0 +1,32 @@
+#pragma once
+
+#include "Walnut/Core/AllocationTracker.h"
+
+#include <string>
+#include <string_view>
+
+namespace Walnut::UI {
+
+	//
+	// ImGui window showing heap usage from the AllocationTracker: live bytes and allocation
+	// rates per tag, and allocations per frame. Call OnUIRender from a layer's OnUIRender.
+	//
+	class MemoryPanel
+	{
+	public:
+		MemoryPanel(std::string_view title = "Walnut Memory");
+		~MemoryPanel() = default;
+
+		void OnUIRender();
+	private:
+		void DrawFrameGraph();
+		void DrawTagTable();
+	private:
+		std::string m_Title;
+		std::string m_DumpPath = "WalnutMemory.txt";
+
+		AllocationStats m_Stats;
+		bool m_Paused = false;
+	};
+
+}
@@ -0,0 +1,198 @@
+#include "ProfilerPanel.h"
+
+#include "Walnut/ApplicationGUI.h"
+
+#include "imgui.h"
+#include "misc/cpp/imgui_stdlib.h"
+
+#include <algorithm>
+
+namespace Walnut::UI {
+
+	namespace Utils {
+
+		static ImU32 GetZoneColor(const char* name)
+		{
+			// Stable color per zone name
+			uint32_t hash = 2166136261u;
+			for (const char* c = name ? name : ""; *c; c++)
+				hash = (hash ^ (uint8_t)*c) * 16777619u;
+
+			float r, g, b;
+			ImGui::ColorConvertHSVtoRGB((hash % 360) / 360.0f, 0.45f, 0.75f, r, g, b);
+			return ImGui::GetColorU32(ImVec4(r, g, b, 1.0f));
+		}
+
+	}
+
+	ProfilerPanel::ProfilerPanel(std::string_view title)
+		: m_Title(title)
+	{
+	}
+
+	void ProfilerPanel::OnUIRender()
+	{
+		ImGui::SetNextWindowSize(ImVec2(900, 500), ImGuiCond_FirstUseEver);
+		if (!ImGui::Begin(m_Title.c_str()))
+		{
+			ImGui::End();
+			return;
+		}
+
+		if (!m_Paused)
+		{
+			m_Capture = Profiler::Capture();
+			m_SelectedFrame = -1;
+		}
+
+		bool enabled = Profiler::IsEnabled();
+		if (ImGui::Checkbox("Enabled", &enabled))
+			Profiler::SetEnabled(enabled);
+
+		ImGui::SameLine();
+		ImGui::Checkbox("Paused", &m_Paused);
+
+		ImGui::SameLine();
+		if (ImGui::Button("Export"))
+			Profiler::ExportChromeTrace(m_Capture, m_ExportPath);
+
+		ImGui::SameLine();
+		ImGui::SetNextItemWidth(240.0f);
+		ImGui::InputText("##ExportPath", &m_ExportPath);
+
+		ImGui::Separator();
+
+		DrawFrameGraph();
+
+		// Timeline covers one complete frame
+		const std::vector<uint64_t>& frames = m_Capture.FrameStarts;
+		if (frames.size() >= 2)
+		{
+			int frame = m_SelectedFrame;
+			if (frame < 0 || frame >= (int)frames.size() - 1)
+				frame = (int)frames.size() - 2;
+
+			const uint64_t start = frames[frame];
+			const uint64_t end = frames[frame + 1];
+			ImGui::Text("Frame %d: %.3f ms", frame, (end - start) * 1e-6);
+
+			ImGui::BeginChild("Timeline", ImVec2(0, 0), false, ImGuiWindowFlags_HorizontalScrollbar);
+			DrawTimeline(start, end);
+			ImGui::EndChild();
+		}
+
+		ImGui::End();
+	}
+
+	void ProfilerPanel::DrawFrameGraph()
+	{
+		const std::vector<uint64_t>& frames = m_Capture.FrameStarts;
+		const float graphHeight = 60.0f;
+		const ImVec2 size(ImGui::GetContentRegionAvail().x, graphHeight);
+		const ImVec2 origin = ImGui::GetCursorScreenPos();
+
+		ImGui::InvisibleButton("FrameGraph", size);
+		const bool hovered = ImGui::IsItemHovered();
+		const bool clicked = ImGui::IsItemClicked();
+
+		ImDrawList* drawList = ImGui::GetWindowDrawList();
+		drawList->AddRectFilled(origin, ImVec2(origin.x + size.x, origin.y + size.y), ImGui::GetColorU32(ImGuiCol_FrameBg));
+
+		const int frameCount = (int)frames.size() - 1;
+		if (frameCount <= 0)
+			return;
+
+		// Scale to the slowest frame, but never below 33 ms so normal frames don't look like spikes
+		double maxMs = 33.3;
+		for (int i = 0; i < frameCount; i++)
+			maxMs = std::max(maxMs, (frames[i + 1] - frames[i]) * 1e-6);
+
+		const float barWidth = size.x / (float)frameCount;
+		for (int i = 0; i < frameCount; i++)
+		{
+			const double ms = (frames[i + 1] - frames[i]) * 1e-6;
+			const float x0 = origin.x + i * barWidth;
+			const float x1 = x0 + std::max(barWidth - 1.0f, 1.0f);
+			const float y0 = origin.y + size.y - (float)(ms / maxMs) * size.y;
+
+			ImU32 color = ms > 33.3 ? IM_COL32(220, 80, 60, 255) : ms > 16.7 ? IM_COL32(220, 180, 60, 255) : IM_COL32(90, 170, 90, 255);
+			if (i == m_SelectedFrame)
+				color = IM_COL32(255, 255, 255, 255);
+
+			drawList->AddRectFilled(ImVec2(x0, y0), ImVec2(x1, origin.y + size.y), color);
+		}
+
+		if (hovered)
+		{
+			const int index = std::clamp((int)((ImGui::GetMousePos().x - origin.x) / barWidth), 0, frameCount - 1);
+			ImGui::SetTooltip("Frame %d: %.3f ms", index, (frames[index + 1] - frames[index]) * 1e-6);
+
+			// Selecting a frame freezes the capture so it stays inspectable
+			if (clicked)
+			{
+				m_SelectedFrame = index;
+				m_Paused = true;
+			}
+		}
+	}
+
+	void ProfilerPanel::DrawTimeline(uint64_t start, uint64_t end)
+	{
+		const float rowHeight = ImGui::GetTextLineHeight() + 4.0f;
+		const float width = ImGui::GetContentRegionAvail().x;
+		const double pixelsPerNs = width / (double)std::max<uint64_t>(end - start, 1);
+
+		ImDrawList* drawList = ImGui::GetWindowDrawList();
+		const ImVec2 mouse = ImGui::GetMousePos();
+
+		for (const ProfileThreadCapture& thread : m_Capture.Threads)
+		{
+			uint32_t maxDepth = 0;
+			bool hasZones = false;
+			for (const ProfileZone& zone : thread.Zones)
+			{
+				if (zone.End <= start || zone.Start >= end)
+					continue;
+
+				maxDepth = std::max(maxDepth, zone.Depth);
+				hasZones = true;
+			}
+
+			if (!hasZones)
+				continue;
+
+			ImGui::PushFont(Application::GetFont("Bold"));
+			ImGui::TextUnformatted(thread.Name.c_str());
+			ImGui::PopFont();
+
+			const ImVec2 origin = ImGui::GetCursorScreenPos();
+			ImGui::Dummy(ImVec2(width, rowHeight * (maxDepth + 1)));
+
+			for (const ProfileZone& zone : thread.Zones)
+			{
+				if (zone.End <= start || zone.Start >= end)
+					continue;
+
+				const float x0 = origin.x + (float)((std::max(zone.Start, start) - start) * pixelsPerNs);
+				const float x1 = origin.x + std::max((float)((std::min(zone.End, end) - start) * pixelsPerNs), x0 - origin.x + 1.0f);
+				const float y0 = origin.y + zone.Depth * rowHeight;
+				const float y1 = y0 + rowHeight - 1.0f;
+
+				drawList->AddRectFilled(ImVec2(x0, y0), ImVec2(x1, y1), Utils::GetZoneColor(zone.Name));
+
+				if (zone.Name && x1 - x0 > 20.0f)
+				{
+					drawList->PushClipRect(ImVec2(x0, y0), ImVec2(x1, y1), true);
+					drawList->AddText(ImVec2(x0 + 3.0f, y0 + 2.0f), IM_COL32(0, 0, 0, 255), zone.Name);
+					drawList->PopClipRect();
+				}
+
+				if (mouse.x >= x0 && mouse.x < x1 && mouse.y >= y0 && mouse.y < y1 && ImGui::IsWindowHovered())
+					ImGui::SetTooltip("%s\n%.3f ms", zone.Name ? zone.Name : "", (zone.End - zone.Start) * 1e-6);
+			}
+
+			ImGui::Spacing();
+		}
+	}
+
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "Walnut/Core/Profiler.h"
+
+#include <string>
+#include <string_view>
+
+namespace Walnut::UI {
+
+	//
+	// ImGui window showing recent frame times and a per-thread zone timeline of one frame.
+	// Call OnUIRender from a layer's OnUIRender.
+	//
+	class ProfilerPanel
+	{
+	public:
+		ProfilerPanel(std::string_view title = "Walnut Profiler");
+		~ProfilerPanel() = default;
+
+		void OnUIRender();
+	private:
+		void DrawFrameGraph();
+		void DrawTimeline(uint64_t start, uint64_t end);
+	private:
+		std::string m_Title;
+		std::string m_ExportPath = "WalnutTrace.json";
+
+		ProfileCapture m_Capture;
+		bool m_Paused = false;
+
+		// Index into m_Capture.FrameStarts, -1 = most recent complete frame
+		int m_SelectedFrame = -1;
+	};
+
+}
@@ -95,6 +95,29 @@ namespace Walnut::UI {
 		DrawButtonImage(image, image, image, tintNormal, tintHovered, tintPressed, ImGui::GetItemRectMin(), ImGui::GetItemRectMax());
 	};
 
+	void DrawButtonImage(const Walnut::AtlasImage& image,
+		ImU32 tintNormal, ImU32 tintHovered, ImU32 tintPressed,
+		ImRect rectangle)
+	{
+		if (!image.IsValid())
+			return;
+
+		ImU32 tint = tintNormal;
+		if (ImGui::IsItemActive())
+			tint = tintPressed;
+		else if (ImGui::IsItemHovered())
+			tint = tintHovered;
+
+		auto* drawList = ImGui::GetForegroundDrawList();
+		drawList->AddImage(image.GetDescriptorSet(), rectangle.Min, rectangle.Max, image.UV0, image.UV1, tint);
+	};
+
+	void DrawButtonImage(const Walnut::AtlasImage& image,
+		ImU32 tintNormal, ImU32 tintHovered, ImU32 tintPressed)
+	{
+		DrawButtonImage(image, tintNormal, tintHovered, tintPressed, GetItemRect());
+	};
+
 	// Exposed to be used for window with disabled decorations
 // This border is going to be drawn even if window border size is set to 0.0f
 	void RenderWindowOuterBorders(ImGuiWindow* window)
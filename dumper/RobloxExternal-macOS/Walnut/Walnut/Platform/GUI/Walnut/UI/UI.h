@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Walnut/Image.h"
+#include "Walnut/ImageAtlas.h"
 
 #include "imgui.h"
 #include "imgui_internal.h"
@@ -40,6 +41,13 @@ namespace Walnut::UI {
 	void DrawButtonImage(const std::shared_ptr<Walnut::Image>& image,
 		ImU32 tintNormal, ImU32 tintHovered, ImU32 tintPressed);
 
+	void DrawButtonImage(const Walnut::AtlasImage& image,
+		ImU32 tintNormal, ImU32 tintHovered, ImU32 tintPressed,
+		ImRect rectangle);
+
+	void DrawButtonImage(const Walnut::AtlasImage& image,
+		ImU32 tintNormal, ImU32 tintHovered, ImU32 tintPressed);
+
 	void RenderWindowOuterBorders(ImGuiWindow* window);
 
 	bool UpdateWindowManualResize(ImGuiWindow* window, ImVec2& newSize, ImVec2& newPosition);
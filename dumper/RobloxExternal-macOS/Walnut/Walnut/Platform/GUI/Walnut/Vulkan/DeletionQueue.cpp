@@ -0,0 +1,187 @@
+#include "DeletionQueue.h"
+
+#include "GPUTimeline.h"
+
+#include "Walnut/ApplicationGUI.h"
+
+#include <deque>
+#include <mutex>
+#include <vector>
+
+namespace Walnut {
+
+	namespace {
+
+		enum class ResourceType : uint8_t
+		{
+			Buffer, Image, ImageView, Sampler, Memory, Texture, Function
+		};
+
+		struct Resource
+		{
+			uint64_t TimelineValue = 0;
+			ResourceType Type = ResourceType::Buffer;
+			uint64_t Handle = 0;
+			MemoryAllocation Allocation;
+		};
+
+		std::mutex s_Mutex;
+
+		// Timeline values only grow, so the front is always the first resource to be ready
+		std::deque<Resource> s_Resources;
+		// In the order of their ResourceType::Function entries
+		std::deque<std::function<void()>> s_Functions;
+
+		// Main thread only, reused by Collect
+		std::vector<Resource> s_Ready;
+		std::vector<std::function<void()>> s_ReadyFunctions;
+
+		// Also waits for the submission after the pending one: ImGui submits secondary
+		// viewports on its own after the main window, without signalling the timeline
+		uint64_t GetReleaseValue()
+		{
+			return GPUTimeline::GetPendingValue() + 1;
+		}
+
+		void Push(ResourceType type, uint64_t handle)
+		{
+			if (!handle)
+				return;
+
+			std::scoped_lock<std::mutex> lock(s_Mutex);
+			Resource& resource = s_Resources.emplace_back();
+			resource.TimelineValue = GetReleaseValue();
+			resource.Type = type;
+			resource.Handle = handle;
+		}
+
+		void Destroy(const Resource& resource)
+		{
+			VkDevice device = Application::GetDevice();
+
+			switch (resource.Type)
+			{
+				case ResourceType::Buffer:    vkDestroyBuffer(device, (VkBuffer)resource.Handle, nullptr); break;
+				case ResourceType::Image:     vkDestroyImage(device, (VkImage)resource.Handle, nullptr); break;
+				case ResourceType::ImageView: vkDestroyImageView(device, (VkImageView)resource.Handle, nullptr); break;
+				case ResourceType::Sampler:   vkDestroySampler(device, (VkSampler)resource.Handle, nullptr); break;
+				case ResourceType::Memory:    MemoryAllocator::Free(resource.Allocation); break;
+				case ResourceType::Texture:   ImGui_ImplVulkan_RemoveTexture((VkDescriptorSet)resource.Handle); break;
+				case ResourceType::Function:  break;
+			}
+		}
+
+	}
+
+	void DeletionQueue::ReleaseBuffer(VkBuffer buffer)
+	{
+		Push(ResourceType::Buffer, (uint64_t)buffer);
+	}
+
+	void DeletionQueue::ReleaseImage(VkImage image)
+	{
+		Push(ResourceType::Image, (uint64_t)image);
+	}
+
+	void DeletionQueue::ReleaseImageView(VkImageView imageView)
+	{
+		Push(ResourceType::ImageView, (uint64_t)imageView);
+	}
+
+	void DeletionQueue::ReleaseSampler(VkSampler sampler)
+	{
+		Push(ResourceType::Sampler, (uint64_t)sampler);
+	}
+
+	void DeletionQueue::ReleaseMemory(const MemoryAllocation& allocation)
+	{
+		if (!allocation.IsValid())
+			return;
+
+		std::scoped_lock<std::mutex> lock(s_Mutex);
+		Resource& resource = s_Resources.emplace_back();
+		resource.TimelineValue = GetReleaseValue();
+		resource.Type = ResourceType::Memory;
+		resource.Allocation = allocation;
+	}
+
+	void DeletionQueue::ReleaseTexture(VkDescriptorSet descriptorSet)
+	{
+		Push(ResourceType::Texture, (uint64_t)descriptorSet);
+	}
+
+	void DeletionQueue::Release(std::function<void()>&& func)
+	{
+		std::scoped_lock<std::mutex> lock(s_Mutex);
+		Resource& resource = s_Resources.emplace_back();
+		resource.TimelineValue = GetReleaseValue();
+		resource.Type = ResourceType::Function;
+		s_Functions.emplace_back(std::move(func));
+	}
+
+	void DeletionQueue::Collect(VkQueue queue)
+	{
+		{
+			std::scoped_lock<std::mutex> lock(s_Mutex);
+			if (s_Resources.empty())
+				return;
+
+			// Nothing else is going to be submitted for a while, move the timeline along ourselves
+			if (queue)
+			{
+				const uint64_t lastValue = s_Resources.back().TimelineValue;
+				while (GPUTimeline::GetPendingValue() <= lastValue)
+					GPUTimeline::Signal(queue);
+			}
+
+			const uint64_t completedValue = GPUTimeline::GetCompletedValue();
+			while (!s_Resources.empty() && s_Resources.front().TimelineValue <= completedValue)
+			{
+				if (s_Resources.front().Type == ResourceType::Function)
+				{
+					s_ReadyFunctions.emplace_back(std::move(s_Functions.front()));
+					s_Functions.pop_front();
+				}
+
+				s_Ready.push_back(s_Resources.front());
+				s_Resources.pop_front();
+			}
+		}
+
+		// Destroy outside the lock, functions may release more resources
+		for (const Resource& resource : s_Ready)
+			Destroy(resource);
+		for (auto& func : s_ReadyFunctions)
+			func();
+
+		s_Ready.clear();
+		s_ReadyFunctions.clear();
+	}
+
+	void DeletionQueue::Flush()
+	{
+		// Releases made while flushing are flushed as well
+		while (true)
+		{
+			{
+				std::scoped_lock<std::mutex> lock(s_Mutex);
+				if (s_Resources.empty())
+					break;
+
+				s_Ready.assign(s_Resources.begin(), s_Resources.end());
+				s_Resources.clear();
+				s_ReadyFunctions.assign(std::make_move_iterator(s_Functions.begin()), std::make_move_iterator(s_Functions.end()));
+				s_Functions.clear();
+			}
+
+			for (const Resource& resource : s_Ready)
+				Destroy(resource);
+			for (auto& func : s_ReadyFunctions)
+				func();
+
+			s_Ready.clear();
+			s_ReadyFunctions.clear();
+		}
+	}
+
+}
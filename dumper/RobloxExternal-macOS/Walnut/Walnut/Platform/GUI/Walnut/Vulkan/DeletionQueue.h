@@ -0,0 +1,40 @@
+#pragma once
+
+#include <functional>
+
+#include "vulkan/vulkan.h"
+
+#include "MemoryAllocator.h"
+
+namespace Walnut {
+
+	//
+	// Deferred destruction of GPU resources
+	//
+	// Released resources are tagged with a GPUTimeline value that is only reached once every
+	// submission that could still use them has completed, and are destroyed by Collect() as soon
+	// as the GPU gets there. Typed releases are stored by value, so they don't allocate.
+	// Release functions are thread-safe, Collect and Flush are main thread only.
+	//
+	class DeletionQueue
+	{
+	public:
+		static void ReleaseBuffer(VkBuffer buffer);
+		static void ReleaseImage(VkImage image);
+		static void ReleaseImageView(VkImageView imageView);
+		static void ReleaseSampler(VkSampler sampler);
+		static void ReleaseMemory(const MemoryAllocation& allocation);
+		// Descriptor set from ImGui_ImplVulkan_AddTexture
+		static void ReleaseTexture(VkDescriptorSet descriptorSet);
+		// For everything else
+		static void Release(std::function<void()>&& func);
+
+		// Destroys everything the GPU is done with. With a queue, also signals the timeline for
+		// releases that are still waiting on a submission, for when no frames are rendered.
+		static void Collect(VkQueue queue = VK_NULL_HANDLE);
+
+		// Destroys everything right away, the device must be idle
+		static void Flush();
+	};
+
+}
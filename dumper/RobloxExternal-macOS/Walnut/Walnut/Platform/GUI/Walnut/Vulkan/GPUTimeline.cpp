@@ -0,0 +1,116 @@
+#include "GPUTimeline.h"
+
+#include <algorithm>
+#include <atomic>
+
+extern void check_vk_result(VkResult err);
+
+namespace Walnut {
+
+	static VkDevice s_Device = VK_NULL_HANDLE;
+	static VkSemaphore s_Semaphore = VK_NULL_HANDLE;
+
+	static std::atomic<uint64_t> s_SubmittedValue = 0;
+	static std::atomic<uint64_t> s_CompletedValue = 0;
+
+	void GPUTimeline::Init(VkDevice device)
+	{
+		s_Device = device;
+
+		VkSemaphoreTypeCreateInfo typeInfo = {};
+		typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+		typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+		typeInfo.initialValue = 0;
+
+		VkSemaphoreCreateInfo info = {};
+		info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+		info.pNext = &typeInfo;
+		VkResult err = vkCreateSemaphore(s_Device, &info, nullptr, &s_Semaphore);
+		check_vk_result(err);
+
+		s_SubmittedValue = 0;
+		s_CompletedValue = 0;
+	}
+
+	void GPUTimeline::Shutdown()
+	{
+		vkDestroySemaphore(s_Device, s_Semaphore, nullptr);
+		s_Semaphore = VK_NULL_HANDLE;
+		s_Device = VK_NULL_HANDLE;
+	}
+
+	VkSemaphore GPUTimeline::GetSemaphore()
+	{
+		return s_Semaphore;
+	}
+
+	uint64_t GPUTimeline::GetPendingValue()
+	{
+		return s_SubmittedValue.load(std::memory_order_acquire) + 1;
+	}
+
+	uint64_t GPUTimeline::BeginSubmission()
+	{
+		return s_SubmittedValue.fetch_add(1, std::memory_order_acq_rel) + 1;
+	}
+
+	uint64_t GPUTimeline::Signal(VkQueue queue)
+	{
+		const uint64_t value = BeginSubmission();
+
+		VkTimelineSemaphoreSubmitInfo timelineInfo = {};
+		timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+		timelineInfo.signalSemaphoreValueCount = 1;
+		timelineInfo.pSignalSemaphoreValues = &value;
+
+		VkSubmitInfo submitInfo = {};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.pNext = &timelineInfo;
+		submitInfo.signalSemaphoreCount = 1;
+		submitInfo.pSignalSemaphores = &s_Semaphore;
+		VkResult err = vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE);
+		check_vk_result(err);
+
+		return value;
+	}
+
+	uint64_t GPUTimeline::GetCompletedValue()
+	{
+		uint64_t value = 0;
+		VkResult err = vkGetSemaphoreCounterValue(s_Device, s_Semaphore, &value);
+		check_vk_result(err);
+
+		// Keep the highest value seen, callers on other threads may race us
+		uint64_t completed = s_CompletedValue.load(std::memory_order_relaxed);
+		while (completed < value && !s_CompletedValue.compare_exchange_weak(completed, value, std::memory_order_relaxed))
+			;
+
+		return std::max(completed, value);
+	}
+
+	bool GPUTimeline::IsComplete(uint64_t value)
+	{
+		// Cheap check first, only query the driver if the cached value is behind
+		if (s_CompletedValue.load(std::memory_order_relaxed) >= value)
+			return true;
+
+		return GetCompletedValue() >= value;
+	}
+
+	void GPUTimeline::Wait(uint64_t value)
+	{
+		if (IsComplete(value))
+			return;
+
+		VkSemaphoreWaitInfo info = {};
+		info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+		info.semaphoreCount = 1;
+		info.pSemaphores = &s_Semaphore;
+		info.pValues = &value;
+		VkResult err = vkWaitSemaphores(s_Device, &info, UINT64_MAX);
+		check_vk_result(err);
+
+		GetCompletedValue();
+	}
+
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+
+#include "vulkan/vulkan.h"
+
+namespace Walnut {
+
+	//
+	// GPU progress tracking with a single timeline semaphore (Vulkan 1.2)
+	//
+	// Every Walnut submission to the graphics queue signals the next value, so a value
+	// stands for "all work submitted up to here". Resources tag themselves with the value
+	// of the submission that uses them and can be reused or freed once it completed.
+	//
+	class GPUTimeline
+	{
+	public:
+		static void Init(VkDevice device);
+		static void Shutdown();
+
+		static VkSemaphore GetSemaphore();
+
+		// Value the next submission will signal. Thread-safe.
+		static uint64_t GetPendingValue();
+
+		// Claims the pending value for a submission that signals GetSemaphore(),
+		// call right before vkQueueSubmit (main thread only)
+		static uint64_t BeginSubmission();
+
+		// Submits an empty batch that signals the next value, for when nothing else
+		// is submitted but resources wait on the timeline (main thread only)
+		static uint64_t Signal(VkQueue queue);
+
+		// Thread-safe
+		static uint64_t GetCompletedValue();
+		static bool IsComplete(uint64_t value);
+		static void Wait(uint64_t value);
+	};
+
+}
@@ -0,0 +1,343 @@
+#include "MemoryAllocator.h"
+
+#include "Walnut/Core/Log.h"
+
+#include <algorithm>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+extern void check_vk_result(VkResult err);
+
+namespace Walnut {
+
+	namespace Internal {
+
+		struct MemoryBlock
+		{
+			VkDeviceMemory Memory = VK_NULL_HANDLE;
+			VkDeviceSize Size = 0;
+			uint8_t* MappedData = nullptr;
+
+			uint32_t PoolIndex = 0;
+			bool Dedicated = false;
+
+			// Offset -> size, adjacent ranges are always merged
+			std::map<VkDeviceSize, VkDeviceSize> FreeRanges;
+			uint32_t AllocationCount = 0;
+		};
+
+	}
+
+	using Internal::MemoryBlock;
+
+	// Bigger requests get a dedicated VkDeviceMemory
+	static constexpr VkDeviceSize s_DefaultBlockSize = 64 * 1024 * 1024;
+
+	static std::mutex s_Mutex;
+	static VkDevice s_Device = VK_NULL_HANDLE;
+	static VkPhysicalDeviceMemoryProperties s_MemoryProperties = {};
+
+	// Two pools per memory type, linear and optimal resources
+	static std::vector<std::unique_ptr<MemoryBlock>> s_Pools[VK_MAX_MEMORY_TYPES * 2];
+	static std::vector<std::unique_ptr<MemoryBlock>> s_DedicatedBlocks;
+
+	static MemoryStats s_Stats;
+
+	namespace Utils {
+
+		static VkDeviceSize AlignUp(VkDeviceSize value, VkDeviceSize alignment)
+		{
+			return alignment > 1 ? (value + alignment - 1) / alignment * alignment : value;
+		}
+
+		static VkDeviceSize GetBlockSize(uint32_t memoryTypeIndex)
+		{
+			// Don't let a single block take a big chunk of small heaps
+			const VkDeviceSize heapSize = s_MemoryProperties.memoryHeaps[s_MemoryProperties.memoryTypes[memoryTypeIndex].heapIndex].size;
+			if (heapSize <= 1024ull * 1024 * 1024)
+				return AlignUp(heapSize / 8, 256);
+
+			return s_DefaultBlockSize;
+		}
+
+		static std::unique_ptr<MemoryBlock> CreateBlock(uint32_t memoryTypeIndex, VkDeviceSize size)
+		{
+			VkMemoryAllocateInfo allocInfo = {};
+			allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+			allocInfo.allocationSize = size;
+			allocInfo.memoryTypeIndex = memoryTypeIndex;
+
+			VkDeviceMemory memory = VK_NULL_HANDLE;
+			VkResult err = vkAllocateMemory(s_Device, &allocInfo, nullptr, &memory);
+			if (err != VK_SUCCESS)
+				return nullptr;
+
+			auto block = std::make_unique<MemoryBlock>();
+			block->Memory = memory;
+			block->Size = size;
+			block->FreeRanges.emplace(0, size);
+
+			if (s_MemoryProperties.memoryTypes[memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+			{
+				void* mappedData = nullptr;
+				err = vkMapMemory(s_Device, memory, 0, VK_WHOLE_SIZE, 0, &mappedData);
+				check_vk_result(err);
+				block->MappedData = (uint8_t*)mappedData;
+			}
+
+			s_Stats.DeviceAllocationCount++;
+			s_Stats.AllocatedBytes += size;
+			return block;
+		}
+
+		static void DestroyBlock(MemoryBlock& block)
+		{
+			if (block.MappedData)
+				vkUnmapMemory(s_Device, block.Memory);
+			vkFreeMemory(s_Device, block.Memory, nullptr);
+
+			s_Stats.DeviceAllocationCount--;
+			s_Stats.AllocatedBytes -= block.Size;
+		}
+
+		// First fit, the alignment padding stays in the free list
+		static bool TryAllocate(MemoryBlock& block, VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& outOffset)
+		{
+			for (auto it = block.FreeRanges.begin(); it != block.FreeRanges.end(); ++it)
+			{
+				const VkDeviceSize rangeOffset = it->first;
+				const VkDeviceSize rangeEnd = it->first + it->second;
+				const VkDeviceSize offset = AlignUp(rangeOffset, alignment);
+				if (offset + size > rangeEnd)
+					continue;
+
+				block.FreeRanges.erase(it);
+				if (offset > rangeOffset)
+					block.FreeRanges.emplace(rangeOffset, offset - rangeOffset);
+				if (offset + size < rangeEnd)
+					block.FreeRanges.emplace(offset + size, rangeEnd - (offset + size));
+
+				block.AllocationCount++;
+				outOffset = offset;
+				return true;
+			}
+
+			return false;
+		}
+
+		static void FreeRange(MemoryBlock& block, VkDeviceSize offset, VkDeviceSize size)
+		{
+			block.AllocationCount--;
+
+			auto next = block.FreeRanges.lower_bound(offset);
+			if (next != block.FreeRanges.end() && offset + size == next->first)
+			{
+				size += next->second;
+				next = block.FreeRanges.erase(next);
+			}
+
+			if (next != block.FreeRanges.begin())
+			{
+				auto previous = std::prev(next);
+				if (previous->first + previous->second == offset)
+				{
+					previous->second += size;
+					return;
+				}
+			}
+
+			block.FreeRanges.emplace(offset, size);
+		}
+
+	}
+
+	void MemoryAllocator::Init(VkDevice device, VkPhysicalDevice physicalDevice)
+	{
+		std::scoped_lock<std::mutex> lock(s_Mutex);
+
+		s_Device = device;
+		vkGetPhysicalDeviceMemoryProperties(physicalDevice, &s_MemoryProperties);
+		s_Stats = {};
+	}
+
+	void MemoryAllocator::Shutdown()
+	{
+		std::scoped_lock<std::mutex> lock(s_Mutex);
+
+		if (s_Stats.AllocationCount > 0)
+			WL_CORE_WARN_TAG("Renderer", "MemoryAllocator::Shutdown - {} allocations ({} bytes) were never freed", s_Stats.AllocationCount, s_Stats.UsedBytes);
+
+		for (auto& pool : s_Pools)
+		{
+			for (auto& block : pool)
+				Utils::DestroyBlock(*block);
+			pool.clear();
+		}
+
+		for (auto& block : s_DedicatedBlocks)
+			Utils::DestroyBlock(*block);
+		s_DedicatedBlocks.clear();
+
+		s_Device = VK_NULL_HANDLE;
+	}
+
+	MemoryAllocation MemoryAllocator::Allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, bool linear)
+	{
+		MemoryAllocation allocation;
+
+		const uint32_t memoryTypeIndex = FindMemoryType(requirements.memoryTypeBits, properties);
+		if (memoryTypeIndex == UINT32_MAX)
+		{
+			WL_CORE_ERROR_TAG("Renderer", "MemoryAllocator::Allocate - no memory type with properties {:#x}", (uint32_t)properties);
+			return allocation;
+		}
+
+		std::scoped_lock<std::mutex> lock(s_Mutex);
+
+		MemoryBlock* block = nullptr;
+		VkDeviceSize offset = 0;
+
+		const VkDeviceSize blockSize = Utils::GetBlockSize(memoryTypeIndex);
+		if (requirements.size > blockSize / 2)
+		{
+			std::unique_ptr<MemoryBlock> dedicated = Utils::CreateBlock(memoryTypeIndex, requirements.size);
+			if (!dedicated)
+			{
+				WL_CORE_ERROR_TAG("Renderer", "MemoryAllocator::Allocate - out of memory ({} bytes)", requirements.size);
+				return allocation;
+			}
+
+			dedicated->Dedicated = true;
+			dedicated->FreeRanges.clear();
+			dedicated->AllocationCount = 1;
+
+			block = s_DedicatedBlocks.emplace_back(std::move(dedicated)).get();
+			s_Stats.DedicatedAllocationCount++;
+		}
+		else
+		{
+			const uint32_t poolIndex = memoryTypeIndex * 2 + (linear ? 1 : 0);
+			auto& pool = s_Pools[poolIndex];
+
+			for (auto& poolBlock : pool)
+			{
+				if (Utils::TryAllocate(*poolBlock, requirements.size, requirements.alignment, offset))
+				{
+					block = poolBlock.get();
+					break;
+				}
+			}
+
+			if (!block)
+			{
+				std::unique_ptr<MemoryBlock> newBlock = Utils::CreateBlock(memoryTypeIndex, blockSize);
+				if (!newBlock)
+				{
+					WL_CORE_ERROR_TAG("Renderer", "MemoryAllocator::Allocate - out of memory ({} byte block)", blockSize);
+					return allocation;
+				}
+
+				newBlock->PoolIndex = poolIndex;
+				block = pool.emplace_back(std::move(newBlock)).get();
+				Utils::TryAllocate(*block, requirements.size, requirements.alignment, offset);
+			}
+		}
+
+		s_Stats.AllocationCount++;
+		s_Stats.UsedBytes += requirements.size;
+
+		allocation.Memory = block->Memory;
+		allocation.Offset = offset;
+		allocation.Size = requirements.size;
+		allocation.MappedData = block->MappedData ? block->MappedData + offset : nullptr;
+		allocation.m_Block = block;
+		return allocation;
+	}
+
+	void MemoryAllocator::Free(const MemoryAllocation& allocation)
+	{
+		if (!allocation.IsValid())
+			return;
+
+		std::scoped_lock<std::mutex> lock(s_Mutex);
+
+		s_Stats.AllocationCount--;
+		s_Stats.UsedBytes -= allocation.Size;
+
+		MemoryBlock* block = allocation.m_Block;
+		if (block->Dedicated)
+		{
+			s_Stats.DedicatedAllocationCount--;
+			Utils::DestroyBlock(*block);
+			std::erase_if(s_DedicatedBlocks, [block](const auto& dedicated) { return dedicated.get() == block; });
+			return;
+		}
+
+		Utils::FreeRange(*block, allocation.Offset, allocation.Size);
+
+		// The last block of a pool stays even when empty, so recreating a single image doesn't hit the driver every time
+		auto& pool = s_Pools[block->PoolIndex];
+		if (block->AllocationCount == 0 && pool.size() > 1)
+		{
+			Utils::DestroyBlock(*block);
+			std::erase_if(pool, [block](const auto& poolBlock) { return poolBlock.get() == block; });
+		}
+	}
+
+	MemoryAllocation MemoryAllocator::AllocateImage(VkImage image, VkMemoryPropertyFlags properties)
+	{
+		VkMemoryRequirements requirements;
+		vkGetImageMemoryRequirements(s_Device, image, &requirements);
+
+		MemoryAllocation allocation = Allocate(requirements, properties, false);
+		if (allocation.IsValid())
+		{
+			VkResult err = vkBindImageMemory(s_Device, image, allocation.Memory, allocation.Offset);
+			check_vk_result(err);
+		}
+
+		return allocation;
+	}
+
+	MemoryAllocation MemoryAllocator::AllocateBuffer(VkBuffer buffer, VkMemoryPropertyFlags properties)
+	{
+		VkMemoryRequirements requirements;
+		vkGetBufferMemoryRequirements(s_Device, buffer, &requirements);
+
+		MemoryAllocation allocation = Allocate(requirements, properties, true);
+		if (allocation.IsValid())
+		{
+			VkResult err = vkBindBufferMemory(s_Device, buffer, allocation.Memory, allocation.Offset);
+			check_vk_result(err);
+		}
+
+		return allocation;
+	}
+
+	uint32_t MemoryAllocator::FindMemoryType(uint32_t typeBits, VkMemoryPropertyFlags properties)
+	{
+		// Written once in Init
+		for (uint32_t i = 0; i < s_MemoryProperties.memoryTypeCount; i++)
+		{
+			if ((s_MemoryProperties.memoryTypes[i].propertyFlags & properties) == properties && typeBits & (1 << i))
+				return i;
+		}
+
+		return UINT32_MAX;
+	}
+
+	const VkPhysicalDeviceMemoryProperties& MemoryAllocator::GetMemoryProperties()
+	{
+		return s_MemoryProperties;
+	}
+
+	MemoryStats MemoryAllocator::GetStats()
+	{
+		std::scoped_lock<std::mutex> lock(s_Mutex);
+		return s_Stats;
+	}
+
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+
+#include "vulkan/vulkan.h"
+
+namespace Walnut {
+
+	namespace Internal {
+
+		struct MemoryBlock;
+
+	}
+
+	struct MemoryAllocation
+	{
+		VkDeviceMemory Memory = VK_NULL_HANDLE;
+		VkDeviceSize Offset = 0;
+		VkDeviceSize Size = 0;
+
+		// Host visible memory stays mapped for its whole lifetime, nullptr otherwise
+		void* MappedData = nullptr;
+
+		bool IsValid() const { return Memory != VK_NULL_HANDLE; }
+	private:
+		Internal::MemoryBlock* m_Block = nullptr;
+
+		friend class MemoryAllocator;
+	};
+
+	struct MemoryStats
+	{
+		// VkDeviceMemory objects and the bytes they reserve
+		uint32_t DeviceAllocationCount = 0;
+		uint64_t AllocatedBytes = 0;
+
+		// Live MemoryAllocations, dedicated ones have a VkDeviceMemory of their own
+		uint32_t AllocationCount = 0;
+		uint32_t DedicatedAllocationCount = 0;
+		uint64_t UsedBytes = 0;
+	};
+
+	//
+	// Pooled GPU memory allocator
+	//
+	// Small resources are sub-allocated from large blocks, one set of blocks per memory type,
+	// so creating an image doesn't cost a vkAllocateMemory and stays far away from the driver's
+	// allocation count limit. Linear (buffers) and optimal (images) resources never share a
+	// block, which keeps bufferImageGranularity out of the picture. Thread-safe.
+	//
+	class MemoryAllocator
+	{
+	public:
+		static void Init(VkDevice device, VkPhysicalDevice physicalDevice);
+		static void Shutdown();
+
+		static MemoryAllocation Allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, bool linear);
+		static void Free(const MemoryAllocation& allocation);
+
+		// Allocate and bind
+		static MemoryAllocation AllocateImage(VkImage image, VkMemoryPropertyFlags properties);
+		static MemoryAllocation AllocateBuffer(VkBuffer buffer, VkMemoryPropertyFlags properties);
+
+		// UINT32_MAX if there is no matching type
+		static uint32_t FindMemoryType(uint32_t typeBits, VkMemoryPropertyFlags properties);
+		static const VkPhysicalDeviceMemoryProperties& GetMemoryProperties();
+
+		static MemoryStats GetStats();
+	};
+
+}
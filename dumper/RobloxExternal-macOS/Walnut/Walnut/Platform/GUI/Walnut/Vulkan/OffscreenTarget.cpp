@@ -0,0 +1,410 @@
+#include "OffscreenTarget.h"
+
+#include "Walnut/ApplicationGUI.h"
+#include "Walnut/Core/Log.h"
+
+#include <algorithm>
+#include <format>
+#include <fstream>
+
+namespace Walnut {
+
+	static constexpr VkFormat s_Format = VK_FORMAT_R8G8B8A8_UNORM;
+
+	OffscreenTarget::OffscreenTarget(ImGui_ImplVulkanH_Window* wd, uint32_t width, uint32_t height, uint32_t queueFamily, uint32_t imageCount)
+		: m_WindowData(wd), m_Width(width), m_Height(height)
+	{
+		VkDevice device = Application::GetDevice();
+		VkResult err;
+
+		wd->Width = (int)width;
+		wd->Height = (int)height;
+		wd->SurfaceFormat.format = s_Format;
+		wd->ImageCount = imageCount;
+		wd->SemaphoreCount = 0;
+		wd->FrameIndex = 0;
+
+		// Render pass, left in TRANSFER_SRC for captures
+		{
+			VkAttachmentDescription attachment = {};
+			attachment.format = s_Format;
+			attachment.samples = VK_SAMPLE_COUNT_1_BIT;
+			attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+			attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+			attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+			attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+			attachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			attachment.finalLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+
+			VkAttachmentReference colorAttachment = {};
+			colorAttachment.attachment = 0;
+			colorAttachment.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+			VkSubpassDescription subpass = {};
+			subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+			subpass.colorAttachmentCount = 1;
+			subpass.pColorAttachments = &colorAttachment;
+
+			VkSubpassDependency dependencies[2] = {};
+
+			// The previous capture copy of the same image has to finish before it is cleared
+			dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+			dependencies[0].dstSubpass = 0;
+			dependencies[0].srcStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+			dependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+			dependencies[0].srcAccessMask = 0;
+			dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+
+			// The capture copy in EndFrame reads what the pass wrote
+			dependencies[1].srcSubpass = 0;
+			dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+			dependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+			dependencies[1].dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+			dependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+			dependencies[1].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+			VkRenderPassCreateInfo info = {};
+			info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+			info.attachmentCount = 1;
+			info.pAttachments = &attachment;
+			info.subpassCount = 1;
+			info.pSubpasses = &subpass;
+			info.dependencyCount = 2;
+			info.pDependencies = dependencies;
+			err = vkCreateRenderPass(device, &info, nullptr, &wd->RenderPass);
+			check_vk_result(err);
+		}
+
+		m_Frames.resize(imageCount);
+		wd->Frames.resize((int)imageCount);
+		for (uint32_t i = 0; i < imageCount; i++)
+		{
+			Frame& frame = m_Frames[i];
+			ImGui_ImplVulkanH_Frame* fd = &wd->Frames[i];
+			memset(fd, 0, sizeof(ImGui_ImplVulkanH_Frame));
+
+			{
+				VkImageCreateInfo info = {};
+				info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+				info.imageType = VK_IMAGE_TYPE_2D;
+				info.format = s_Format;
+				info.extent = { width, height, 1 };
+				info.mipLevels = 1;
+				info.arrayLayers = 1;
+				info.samples = VK_SAMPLE_COUNT_1_BIT;
+				info.tiling = VK_IMAGE_TILING_OPTIMAL;
+				info.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+				info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+				info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+				err = vkCreateImage(device, &info, nullptr, &frame.Image);
+				check_vk_result(err);
+				frame.ImageAllocation = MemoryAllocator::AllocateImage(frame.Image, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+				// Nothing can be rendered without the render targets, fail like any other Vulkan error
+				if (!frame.ImageAllocation.IsValid())
+				{
+					WL_CORE_ERROR_TAG("Renderer", "Failed to allocate memory for the {}x{} offscreen images", width, height);
+					check_vk_result(VK_ERROR_OUT_OF_DEVICE_MEMORY);
+				}
+				fd->Backbuffer = frame.Image;
+			}
+			{
+				VkImageViewCreateInfo info = {};
+				info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+				info.image = frame.Image;
+				info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+				info.format = s_Format;
+				info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+				info.subresourceRange.levelCount = 1;
+				info.subresourceRange.layerCount = 1;
+				err = vkCreateImageView(device, &info, nullptr, &fd->BackbufferView);
+				check_vk_result(err);
+			}
+			{
+				VkFramebufferCreateInfo info = {};
+				info.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+				info.renderPass = wd->RenderPass;
+				info.attachmentCount = 1;
+				info.pAttachments = &fd->BackbufferView;
+				info.width = width;
+				info.height = height;
+				info.layers = 1;
+				err = vkCreateFramebuffer(device, &info, nullptr, &fd->Framebuffer);
+				check_vk_result(err);
+			}
+			{
+				VkCommandPoolCreateInfo info = {};
+				info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+				info.queueFamilyIndex = queueFamily;
+				err = vkCreateCommandPool(device, &info, nullptr, &fd->CommandPool);
+				check_vk_result(err);
+			}
+			{
+				VkCommandBufferAllocateInfo info = {};
+				info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+				info.commandPool = fd->CommandPool;
+				info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+				info.commandBufferCount = 1;
+				err = vkAllocateCommandBuffers(device, &info, &fd->CommandBuffer);
+				check_vk_result(err);
+			}
+			{
+				VkFenceCreateInfo info = {};
+				info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+				info.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+				err = vkCreateFence(device, &info, nullptr, &fd->Fence);
+				check_vk_result(err);
+			}
+		}
+
+		// GPU timings, two timestamps per frame
+		uint32_t queueFamilyCount = 0;
+		vkGetPhysicalDeviceQueueFamilyProperties(Application::GetPhysicalDevice(), &queueFamilyCount, nullptr);
+		std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+		vkGetPhysicalDeviceQueueFamilyProperties(Application::GetPhysicalDevice(), &queueFamilyCount, queueFamilies.data());
+
+		const uint32_t validBits = queueFamilies[queueFamily].timestampValidBits;
+		if (validBits > 0)
+		{
+			VkPhysicalDeviceProperties properties;
+			vkGetPhysicalDeviceProperties(Application::GetPhysicalDevice(), &properties);
+			m_TimestampPeriod = properties.limits.timestampPeriod / 1000000.0;
+			m_TimestampMask = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+
+			VkQueryPoolCreateInfo info = {};
+			info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+			info.queryType = VK_QUERY_TYPE_TIMESTAMP;
+			info.queryCount = imageCount * 2;
+			err = vkCreateQueryPool(device, &info, nullptr, &m_QueryPool);
+			check_vk_result(err);
+		}
+		else
+		{
+			WL_CORE_WARN_TAG("Renderer", "Queue has no timestamp support, offscreen GPU timings are disabled");
+		}
+	}
+
+	OffscreenTarget::~OffscreenTarget()
+	{
+		VkDevice device = Application::GetDevice();
+
+		for (uint32_t i = 0; i < (uint32_t)m_Frames.size(); i++)
+		{
+			Frame& frame = m_Frames[i];
+			ImGui_ImplVulkanH_Frame* fd = &m_WindowData->Frames[i];
+
+			vkDestroyFence(device, fd->Fence, nullptr);
+			vkFreeCommandBuffers(device, fd->CommandPool, 1, &fd->CommandBuffer);
+			vkDestroyCommandPool(device, fd->CommandPool, nullptr);
+			vkDestroyFramebuffer(device, fd->Framebuffer, nullptr);
+			vkDestroyImageView(device, fd->BackbufferView, nullptr);
+			vkDestroyImage(device, frame.Image, nullptr);
+			MemoryAllocator::Free(frame.ImageAllocation);
+
+			if (frame.ReadbackBuffer)
+			{
+				vkDestroyBuffer(device, frame.ReadbackBuffer, nullptr);
+				MemoryAllocator::Free(frame.ReadbackAllocation);
+			}
+		}
+
+		if (m_QueryPool)
+			vkDestroyQueryPool(device, m_QueryPool, nullptr);
+
+		vkDestroyRenderPass(device, m_WindowData->RenderPass, nullptr);
+		m_WindowData->RenderPass = VK_NULL_HANDLE;
+		m_WindowData->Frames.clear();
+		m_WindowData->ImageCount = 0;
+	}
+
+	void OffscreenTarget::SetCapture(const std::filesystem::path& directory, uint32_t captureInterval)
+	{
+		m_CaptureDirectory = directory;
+		m_CaptureInterval = directory.empty() ? 0 : captureInterval;
+
+		if (m_CaptureInterval > 0)
+		{
+			std::error_code error;
+			std::filesystem::create_directories(m_CaptureDirectory, error);
+		}
+	}
+
+	void OffscreenTarget::BeginFrame(uint32_t frameIndex, VkCommandBuffer commandBuffer)
+	{
+		Frame& frame = m_Frames[frameIndex];
+		frame.Pending = true;
+		frame.Timing = {};
+		frame.Timing.Frame = m_FrameCount++;
+		frame.Capture = m_CaptureInterval > 0 && frame.Timing.Frame % m_CaptureInterval == 0;
+
+		if (m_QueryPool)
+		{
+			vkCmdResetQueryPool(commandBuffer, m_QueryPool, frameIndex * 2, 2);
+			vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_QueryPool, frameIndex * 2);
+		}
+	}
+
+	void OffscreenTarget::EndFrame(uint32_t frameIndex, VkCommandBuffer commandBuffer)
+	{
+		Frame& frame = m_Frames[frameIndex];
+
+		if (m_QueryPool)
+			vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_QueryPool, frameIndex * 2 + 1);
+
+		if (!frame.Capture)
+			return;
+
+		if (!frame.ReadbackBuffer)
+		{
+			VkBufferCreateInfo info = {};
+			info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+			info.size = (VkDeviceSize)m_Width * m_Height * 4;
+			info.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+			info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+			VkResult err = vkCreateBuffer(Application::GetDevice(), &info, nullptr, &frame.ReadbackBuffer);
+			check_vk_result(err);
+
+			// Cached memory if there is any, the CPU reads every pixel
+			VkMemoryPropertyFlags properties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+			if (MemoryAllocator::FindMemoryType(~0u, properties | VK_MEMORY_PROPERTY_HOST_CACHED_BIT) != UINT32_MAX)
+				properties |= VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+			frame.ReadbackAllocation = MemoryAllocator::AllocateBuffer(frame.ReadbackBuffer, properties);
+
+			if (!frame.ReadbackAllocation.IsValid())
+			{
+				WL_CORE_WARN_TAG("Renderer", "No host visible memory for offscreen captures");
+				vkDestroyBuffer(Application::GetDevice(), frame.ReadbackBuffer, nullptr);
+				frame.ReadbackBuffer = VK_NULL_HANDLE;
+				frame.Capture = false;
+				return;
+			}
+		}
+
+		// The render pass left the image in TRANSFER_SRC
+		VkBufferImageCopy copy = {};
+		copy.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		copy.imageSubresource.layerCount = 1;
+		copy.imageExtent = { m_Width, m_Height, 1 };
+		vkCmdCopyImageToBuffer(commandBuffer, frame.Image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, frame.ReadbackBuffer, 1, &copy);
+
+		VkBufferMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.buffer = frame.ReadbackBuffer;
+		barrier.size = VK_WHOLE_SIZE;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+	}
+
+	void OffscreenTarget::SetFrameCPUTime(uint32_t frameIndex, double milliseconds)
+	{
+		m_Frames[frameIndex].Timing.CPUTime = milliseconds;
+	}
+
+	void OffscreenTarget::CollectFrame(uint32_t frameIndex)
+	{
+		Frame& frame = m_Frames[frameIndex];
+		if (!frame.Pending)
+			return;
+
+		if (m_QueryPool)
+		{
+			// The frame's fence has been waited on, so this doesn't block
+			uint64_t timestamps[2] = {};
+			VkResult err = vkGetQueryPoolResults(Application::GetDevice(), m_QueryPool, frameIndex * 2, 2,
+				sizeof(timestamps), timestamps, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT);
+			if (err == VK_SUCCESS)
+				frame.Timing.GPUTime = (double)((timestamps[1] - timestamps[0]) & m_TimestampMask) * m_TimestampPeriod;
+		}
+
+		if (frame.Capture)
+			WriteCapture(frame);
+
+		m_Timings.push_back(frame.Timing);
+		frame.Pending = false;
+	}
+
+	void OffscreenTarget::CollectAll()
+	{
+		// Oldest frame first, so the timings stay in order
+		std::vector<uint32_t> pending;
+		for (uint32_t i = 0; i < (uint32_t)m_Frames.size(); i++)
+		{
+			if (m_Frames[i].Pending)
+				pending.push_back(i);
+		}
+		std::sort(pending.begin(), pending.end(), [this](uint32_t a, uint32_t b) { return m_Frames[a].Timing.Frame < m_Frames[b].Timing.Frame; });
+
+		for (uint32_t frameIndex : pending)
+			CollectFrame(frameIndex);
+	}
+
+	void OffscreenTarget::WriteCapture(const Frame& frame) const
+	{
+		if (!frame.ReadbackAllocation.MappedData)
+			return;
+
+		std::filesystem::path filepath = m_CaptureDirectory / std::format("frame_{:06}.ppm", frame.Timing.Frame);
+		std::ofstream stream(filepath, std::ios::binary | std::ios::trunc);
+		if (!stream)
+		{
+			WL_CORE_WARN_TAG("Renderer", "Failed to write offscreen capture {}", filepath.string());
+			return;
+		}
+
+		// Binary PPM, alpha is dropped
+		stream << std::format("P6\n{} {}\n255\n", m_Width, m_Height);
+
+		const uint8_t* pixels = (const uint8_t*)frame.ReadbackAllocation.MappedData;
+		std::vector<uint8_t> row((size_t)m_Width * 3);
+		for (uint32_t y = 0; y < m_Height; y++)
+		{
+			const uint8_t* src = pixels + (size_t)y * m_Width * 4;
+			for (uint32_t x = 0; x < m_Width; x++)
+			{
+				row[x * 3 + 0] = src[x * 4 + 0];
+				row[x * 3 + 1] = src[x * 4 + 1];
+				row[x * 3 + 2] = src[x * 4 + 2];
+			}
+			stream.write((const char*)row.data(), (std::streamsize)row.size());
+		}
+	}
+
+	void OffscreenTarget::LogSummary() const
+	{
+		if (m_Timings.empty())
+			return;
+
+		auto summarize = [this](auto getTime, std::string_view name)
+		{
+			std::vector<double> times;
+			times.reserve(m_Timings.size());
+			for (const OffscreenFrameTiming& timing : m_Timings)
+			{
+				// Negative when the frame has no measurement
+				const double time = getTime(timing);
+				if (time >= 0.0)
+					times.push_back(time);
+			}
+			if (times.empty())
+				return;
+
+			std::sort(times.begin(), times.end());
+
+			double total = 0.0;
+			for (double time : times)
+				total += time;
+
+			auto percentile = [&times](double p) { return times[std::min(times.size() - 1, (size_t)(p * (double)times.size()))]; };
+			WL_CORE_INFO_TAG("Renderer", "{} frame time over {} frames: avg {:.3f} ms, p50 {:.3f} ms, p99 {:.3f} ms, max {:.3f} ms",
+				name, times.size(), total / (double)times.size(), percentile(0.5), percentile(0.99), times.back());
+		};
+
+		summarize([](const OffscreenFrameTiming& timing) { return timing.CPUTime; }, "CPU");
+		if (m_QueryPool)
+			summarize([](const OffscreenFrameTiming& timing) { return timing.GPUTime; }, "GPU");
+	}
+
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "MemoryAllocator.h"
+
+#include "backends/imgui_impl_vulkan.h"
+#include "vulkan/vulkan.h"
+
+#include <filesystem>
+#include <vector>
+
+namespace Walnut {
+
+	struct OffscreenFrameTiming
+	{
+		uint64_t Frame = 0;
+		// Milliseconds, GPUTime is negative when it couldn't be measured
+		double CPUTime = 0.0;
+		double GPUTime = -1.0;
+	};
+
+	//
+	// Render target for ApplicationSpecification::Offscreen: RGBA8 images in place of a swapchain,
+	// so the GUI render path runs without a window or surface (eg. on lavapipe in CI).
+	// It fills the ImGui_ImplVulkanH_Window FrameRender uses, times every frame on the GPU with
+	// timestamp queries and can dump frames as PPM images. Main thread only.
+	//
+	class OffscreenTarget
+	{
+	public:
+		OffscreenTarget(ImGui_ImplVulkanH_Window* wd, uint32_t width, uint32_t height, uint32_t queueFamily, uint32_t imageCount);
+		~OffscreenTarget();
+
+		// Every captureInterval frames is written to directory/frame_<n>.ppm, 0 = no captures
+		void SetCapture(const std::filesystem::path& directory, uint32_t captureInterval);
+
+		// Recorded at the start and end of the frame's command buffer, after the render pass
+		void BeginFrame(uint32_t frameIndex, VkCommandBuffer commandBuffer);
+		void EndFrame(uint32_t frameIndex, VkCommandBuffer commandBuffer);
+		// CPU time of the frame that was just submitted
+		void SetFrameCPUTime(uint32_t frameIndex, double milliseconds);
+
+		// Reads back timings and captures, once the frame's fence has been waited on
+		void CollectFrame(uint32_t frameIndex);
+		// Same for every frame, the device must be idle
+		void CollectAll();
+
+		uint64_t GetFrameCount() const { return m_FrameCount; }
+		// Counts and times from frame 0 again (soft restart), every frame must have been collected
+		void ResetFrameCount() { m_FrameCount = 0; m_Timings.clear(); }
+		const std::vector<OffscreenFrameTiming>& GetTimings() const { return m_Timings; }
+
+		// Average, median, p99 and worst frame times
+		void LogSummary() const;
+	private:
+		struct Frame
+		{
+			VkImage Image = VK_NULL_HANDLE;
+			MemoryAllocation ImageAllocation;
+
+			// Created for the first capture
+			VkBuffer ReadbackBuffer = VK_NULL_HANDLE;
+			MemoryAllocation ReadbackAllocation;
+
+			bool Pending = false;
+			bool Capture = false;
+			OffscreenFrameTiming Timing;
+		};
+
+		void WriteCapture(const Frame& frame) const;
+	private:
+		ImGui_ImplVulkanH_Window* m_WindowData;
+		uint32_t m_Width, m_Height;
+		std::vector<Frame> m_Frames;
+
+		VkQueryPool m_QueryPool = VK_NULL_HANDLE;
+		double m_TimestampPeriod = 0.0; // Milliseconds per tick
+		uint64_t m_TimestampMask = 0;
+
+		std::filesystem::path m_CaptureDirectory;
+		uint32_t m_CaptureInterval = 0;
+
+		uint64_t m_FrameCount = 0;
+		std::vector<OffscreenFrameTiming> m_Timings;
+	};
+
+}
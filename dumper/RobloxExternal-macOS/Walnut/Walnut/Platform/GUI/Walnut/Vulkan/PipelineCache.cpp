@@ -0,0 +1,184 @@
+#include "PipelineCache.h"
+
+#include "Walnut/ApplicationGUI.h"
+#include "Walnut/Core/Log.h"
+
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+namespace Walnut {
+
+	namespace {
+
+		constexpr uint32_t s_Magic = 0x43505657; // "WVPC"
+		constexpr uint32_t s_Version = 1;
+
+		struct FileHeader
+		{
+			uint32_t Magic = s_Magic;
+			uint32_t Version = s_Version;
+			uint32_t VendorID = 0;
+			uint32_t DeviceID = 0;
+			uint32_t DriverVersion = 0;
+			uint8_t PipelineCacheUUID[VK_UUID_SIZE] = {};
+			uint64_t DataSize = 0;
+			uint64_t DataHash = 0;
+		};
+
+		uint64_t HashData(const uint8_t* data, size_t size)
+		{
+			// FNV-1a
+			uint64_t hash = 14695981039346656037ull;
+			for (size_t i = 0; i < size; i++)
+			{
+				hash ^= data[i];
+				hash *= 1099511628211ull;
+			}
+			return hash;
+		}
+
+	}
+
+	static VkDevice s_Device = VK_NULL_HANDLE;
+	static VkPipelineCache s_PipelineCache = VK_NULL_HANDLE;
+	static FileHeader s_DeviceHeader;
+	static std::filesystem::path s_Filepath;
+
+	// Cached data for this device, empty if there is none or it doesn't match
+	static std::vector<uint8_t> LoadCacheData(const std::filesystem::path& filepath)
+	{
+		std::ifstream stream(filepath, std::ios::binary);
+		if (!stream)
+			return {};
+
+		FileHeader header;
+		if (!stream.read((char*)&header, sizeof(FileHeader)))
+			return {};
+
+		if (header.Magic != s_Magic || header.Version != s_Version
+			|| header.VendorID != s_DeviceHeader.VendorID || header.DeviceID != s_DeviceHeader.DeviceID
+			|| header.DriverVersion != s_DeviceHeader.DriverVersion
+			|| memcmp(header.PipelineCacheUUID, s_DeviceHeader.PipelineCacheUUID, VK_UUID_SIZE) != 0)
+		{
+			WL_CORE_INFO_TAG("Renderer", "Pipeline cache was created by another device or driver, rebuilding it");
+			return {};
+		}
+
+		// The size comes from disk, check it against the file before allocating
+		std::error_code error;
+		const uint64_t fileSize = std::filesystem::file_size(filepath, error);
+		if (error || header.DataSize > fileSize - sizeof(FileHeader))
+		{
+			WL_CORE_WARN_TAG("Renderer", "Pipeline cache {} is truncated, rebuilding it", filepath.string());
+			return {};
+		}
+
+		std::vector<uint8_t> data(header.DataSize);
+		if (!stream.read((char*)data.data(), (std::streamsize)data.size()) || HashData(data.data(), data.size()) != header.DataHash)
+		{
+			WL_CORE_WARN_TAG("Renderer", "Pipeline cache {} is corrupt, rebuilding it", filepath.string());
+			return {};
+		}
+
+		return data;
+	}
+
+	void PipelineCache::Init(VkDevice device, VkPhysicalDevice physicalDevice, const std::filesystem::path& filepath)
+	{
+		s_Device = device;
+		s_Filepath = filepath;
+
+		VkPhysicalDeviceProperties properties;
+		vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+		s_DeviceHeader.VendorID = properties.vendorID;
+		s_DeviceHeader.DeviceID = properties.deviceID;
+		s_DeviceHeader.DriverVersion = properties.driverVersion;
+		memcpy(s_DeviceHeader.PipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE);
+
+		std::vector<uint8_t> data;
+		if (!s_Filepath.empty())
+			data = LoadCacheData(s_Filepath);
+
+		VkPipelineCacheCreateInfo info = {};
+		info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+		info.initialDataSize = data.size();
+		info.pInitialData = data.empty() ? nullptr : data.data();
+		VkResult err = vkCreatePipelineCache(s_Device, &info, nullptr, &s_PipelineCache);
+
+		// Drivers are allowed to reject the data, start over with an empty cache
+		if (err != VK_SUCCESS && !data.empty())
+		{
+			info.initialDataSize = 0;
+			info.pInitialData = nullptr;
+			err = vkCreatePipelineCache(s_Device, &info, nullptr, &s_PipelineCache);
+		}
+		check_vk_result(err);
+	}
+
+	void PipelineCache::Shutdown()
+	{
+		if (!s_PipelineCache)
+			return;
+
+		Save();
+
+		vkDestroyPipelineCache(s_Device, s_PipelineCache, nullptr);
+		s_PipelineCache = VK_NULL_HANDLE;
+		s_Device = VK_NULL_HANDLE;
+	}
+
+	bool PipelineCache::Save()
+	{
+		if (!s_PipelineCache || s_Filepath.empty())
+			return false;
+
+		size_t size = 0;
+		VkResult err = vkGetPipelineCacheData(s_Device, s_PipelineCache, &size, nullptr);
+		if (err != VK_SUCCESS || size == 0)
+			return false;
+
+		std::vector<uint8_t> data(size);
+		err = vkGetPipelineCacheData(s_Device, s_PipelineCache, &size, data.data());
+		if (err != VK_SUCCESS)
+			return false;
+		data.resize(size);
+
+		FileHeader header = s_DeviceHeader;
+		header.DataSize = data.size();
+		header.DataHash = HashData(data.data(), data.size());
+
+		std::error_code error;
+		std::filesystem::create_directories(s_Filepath.parent_path(), error);
+
+		// Written next to the cache and moved over it, so a crash never leaves a half-written file behind
+		std::filesystem::path tempFilepath = s_Filepath;
+		tempFilepath += ".tmp";
+		{
+			std::ofstream stream(tempFilepath, std::ios::binary | std::ios::trunc);
+			stream.write((const char*)&header, sizeof(FileHeader));
+			stream.write((const char*)data.data(), (std::streamsize)data.size());
+			if (!stream)
+			{
+				WL_CORE_WARN_TAG("Renderer", "Failed to write pipeline cache {}", tempFilepath.string());
+				return false;
+			}
+		}
+
+		std::filesystem::rename(tempFilepath, s_Filepath, error);
+		if (error)
+		{
+			WL_CORE_WARN_TAG("Renderer", "Failed to save pipeline cache {}: {}", s_Filepath.string(), error.message());
+			std::filesystem::remove(tempFilepath, error);
+			return false;
+		}
+
+		return true;
+	}
+
+	VkPipelineCache PipelineCache::Get()
+	{
+		return s_PipelineCache;
+	}
+
+}
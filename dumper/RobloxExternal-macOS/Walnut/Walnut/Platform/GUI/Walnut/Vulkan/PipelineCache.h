@@ -0,0 +1,28 @@
+#pragma once
+
+#include "vulkan/vulkan.h"
+
+#include <filesystem>
+
+namespace Walnut {
+
+	//
+	// VkPipelineCache persisted between runs, so pipelines aren't compiled from scratch on every launch.
+	// The blob is stored with its own header (vendor, device, driver version and cache UUID plus a
+	// checksum) and thrown away when any of it doesn't match, since not every driver validates it.
+	// Pass Get() to every vkCreate*Pipelines call.
+	//
+	class PipelineCache
+	{
+	public:
+		static void Init(VkDevice device, VkPhysicalDevice physicalDevice, const std::filesystem::path& filepath);
+		// Saves and destroys the cache, call while the device is still alive
+		static void Shutdown();
+
+		// Writes the current contents to disk, also done by Shutdown
+		static bool Save();
+
+		static VkPipelineCache Get();
+	};
+
+}
@@ -0,0 +1,53 @@
+#include "SamplerCache.h"
+
+#include "Walnut/ApplicationGUI.h"
+
+#include <mutex>
+#include <unordered_map>
+
+namespace Walnut {
+
+	static std::mutex s_Mutex;
+	static std::unordered_map<uint64_t, VkSampler> s_Samplers;
+
+	VkSampler SamplerCache::Get(VkFilter filter, VkSamplerAddressMode addressMode)
+	{
+		const uint64_t key = (uint64_t)filter << 32 | (uint64_t)addressMode;
+
+		std::scoped_lock<std::mutex> lock(s_Mutex);
+
+		auto it = s_Samplers.find(key);
+		if (it != s_Samplers.end())
+			return it->second;
+
+		VkSamplerCreateInfo info = {};
+		info.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+		info.magFilter = filter;
+		info.minFilter = filter;
+		info.mipmapMode = filter == VK_FILTER_NEAREST ? VK_SAMPLER_MIPMAP_MODE_NEAREST : VK_SAMPLER_MIPMAP_MODE_LINEAR;
+		info.addressModeU = addressMode;
+		info.addressModeV = addressMode;
+		info.addressModeW = addressMode;
+		info.minLod = -1000;
+		info.maxLod = 1000;
+		info.maxAnisotropy = 1.0f;
+
+		VkSampler sampler = VK_NULL_HANDLE;
+		VkResult err = vkCreateSampler(Application::GetDevice(), &info, nullptr, &sampler);
+		check_vk_result(err);
+
+		s_Samplers.emplace(key, sampler);
+		return sampler;
+	}
+
+	void SamplerCache::Shutdown()
+	{
+		std::scoped_lock<std::mutex> lock(s_Mutex);
+
+		VkDevice device = Application::GetDevice();
+		for (auto& [key, sampler] : s_Samplers)
+			vkDestroySampler(device, sampler, nullptr);
+		s_Samplers.clear();
+	}
+
+}
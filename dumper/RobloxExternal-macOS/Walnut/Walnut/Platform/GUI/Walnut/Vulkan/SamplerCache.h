@@ -0,0 +1,17 @@
+#pragma once
+
+#include "vulkan/vulkan.h"
+
+namespace Walnut {
+
+	// Samplers are immutable, so every image with the same filtering shares one. Thread-safe.
+	class SamplerCache
+	{
+	public:
+		static VkSampler Get(VkFilter filter, VkSamplerAddressMode addressMode);
+
+		// Called by the Application once nothing uses the samplers anymore
+		static void Shutdown();
+	};
+
+}
@@ -0,0 +1,296 @@
+#include "UploadQueue.h"
+
+#include "GPUTimeline.h"
+#include "MemoryAllocator.h"
+
+#include "Walnut/ApplicationGUI.h"
+
+#include <algorithm>
+
+namespace Walnut {
+
+	namespace Utils {
+
+		static void CreateMappedBuffer(VkDevice device, VkDeviceSize size, VkBuffer& outBuffer, MemoryAllocation& outAllocation)
+		{
+			VkBufferCreateInfo bufferInfo = {};
+			bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+			bufferInfo.size = size;
+			bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+			bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+			VkResult err = vkCreateBuffer(device, &bufferInfo, nullptr, &outBuffer);
+			check_vk_result(err);
+
+			outAllocation = MemoryAllocator::AllocateBuffer(outBuffer, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+		}
+
+		static uint64_t AlignUp(uint64_t value, uint64_t alignment)
+		{
+			return (value + alignment - 1) / alignment * alignment;
+		}
+
+	}
+
+	UploadQueue::UploadQueue(VkDevice device, uint32_t queueFamily, VkDeviceSize ringSize)
+		: m_Device(device)
+	{
+		// Keeps every aligned offset aligned after wrapping around
+		m_RingSize = Utils::AlignUp(std::max<VkDeviceSize>(ringSize, 256), 256);
+
+		Utils::CreateMappedBuffer(m_Device, m_RingSize, m_RingBuffer, m_RingAllocation);
+		m_RingData = (uint8_t*)m_RingAllocation.MappedData;
+
+		VkCommandPoolCreateInfo poolInfo = {};
+		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT | VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+		poolInfo.queueFamilyIndex = queueFamily;
+		VkResult err = vkCreateCommandPool(m_Device, &poolInfo, nullptr, &m_CommandPool);
+		check_vk_result(err);
+	}
+
+	UploadQueue::~UploadQueue()
+	{
+		// The Application waits for the device to be idle before destroying the queue
+		for (const DedicatedBuffer& dedicated : m_DedicatedBuffers)
+		{
+			vkDestroyBuffer(m_Device, dedicated.Buffer, nullptr);
+			MemoryAllocator::Free(dedicated.Allocation);
+		}
+
+		vkDestroyCommandPool(m_Device, m_CommandPool, nullptr);
+
+		vkDestroyBuffer(m_Device, m_RingBuffer, nullptr);
+		MemoryAllocator::Free(m_RingAllocation);
+	}
+
+	StagingAllocation UploadQueue::AllocateStaging(VkDeviceSize size, VkDeviceSize alignment)
+	{
+		if (size > m_RingSize)
+			return AllocateDedicated(size);
+
+		Reclaim();
+
+		uint64_t offset = Utils::AlignUp(m_Head, alignment);
+
+		// Allocations are contiguous, skip the end of the ring if it's too small
+		if (offset % m_RingSize + size > m_RingSize)
+			offset += m_RingSize - offset % m_RingSize;
+
+		while (offset + size - m_Tail > m_RingSize)
+		{
+			// The rest of the ring holds uploads that haven't been submitted yet, waiting won't free it
+			if (m_InFlightRanges.empty())
+				return AllocateDedicated(size);
+
+			GPUTimeline::Wait(m_InFlightRanges.front().TimelineValue);
+			Reclaim();
+		}
+
+		m_Head = offset + size;
+
+		StagingAllocation allocation;
+		allocation.Buffer = m_RingBuffer;
+		allocation.Offset = offset % m_RingSize;
+		allocation.Size = size;
+		allocation.Data = m_RingData + allocation.Offset;
+		return allocation;
+	}
+
+	StagingAllocation UploadQueue::AllocateDedicated(VkDeviceSize size)
+	{
+		DedicatedBuffer& dedicated = m_DedicatedBuffers.emplace_back();
+
+		Utils::CreateMappedBuffer(m_Device, size, dedicated.Buffer, dedicated.Allocation);
+		if (!dedicated.Allocation.IsValid())
+		{
+			vkDestroyBuffer(m_Device, dedicated.Buffer, nullptr);
+			m_DedicatedBuffers.pop_back();
+			return {};
+		}
+
+		StagingAllocation allocation;
+		allocation.Data = dedicated.Allocation.MappedData;
+		allocation.Buffer = dedicated.Buffer;
+		allocation.Size = size;
+		return allocation;
+	}
+
+	void UploadQueue::UploadToImage(const StagingAllocation& staging, VkImage image, const VkBufferImageCopy* regions, uint32_t regionCount, bool preserveContents)
+	{
+		PendingUpload& upload = m_PendingUploads.emplace_back();
+		upload.Buffer = staging.Buffer;
+		upload.Image = image;
+		upload.PreserveContents = preserveContents;
+		upload.FirstRegion = (uint32_t)m_PendingRegions.size();
+		upload.RegionCount = regionCount;
+
+		for (uint32_t i = 0; i < regionCount; i++)
+		{
+			VkBufferImageCopy& region = m_PendingRegions.emplace_back(regions[i]);
+			region.bufferOffset += staging.Offset;
+		}
+	}
+
+	void UploadQueue::Record(VkCommandBuffer commandBuffer, uint64_t timelineValue)
+	{
+		std::vector<VkImageMemoryBarrier> barriers;
+		std::vector<VkImage> segmentImages;
+		std::vector<VkImage> uploadedImages;
+
+		auto imageBarrier = [](VkImage image, VkImageLayout oldLayout, VkImageLayout newLayout, VkAccessFlags srcAccess, VkAccessFlags dstAccess)
+		{
+			VkImageMemoryBarrier barrier = {};
+			barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+			barrier.srcAccessMask = srcAccess;
+			barrier.dstAccessMask = dstAccess;
+			barrier.oldLayout = oldLayout;
+			barrier.newLayout = newLayout;
+			barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.image = image;
+			barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			barrier.subresourceRange.levelCount = 1;
+			barrier.subresourceRange.layerCount = 1;
+			return barrier;
+		};
+
+		// Uploads are batched into segments that touch every image at most once,
+		// so each segment needs a single barrier before and after its copies
+		size_t begin = 0;
+		while (begin < m_PendingUploads.size())
+		{
+			size_t end = begin;
+			segmentImages.clear();
+			while (end < m_PendingUploads.size() && std::find(segmentImages.begin(), segmentImages.end(), m_PendingUploads[end].Image) == segmentImages.end())
+				segmentImages.push_back(m_PendingUploads[end++].Image);
+
+			// Earlier frames may still be sampling these images
+			barriers.clear();
+			for (size_t i = begin; i < end; i++)
+			{
+				const PendingUpload& upload = m_PendingUploads[i];
+				const bool preserve = upload.PreserveContents || std::find(uploadedImages.begin(), uploadedImages.end(), upload.Image) != uploadedImages.end();
+				barriers.push_back(imageBarrier(upload.Image, preserve ? VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_UNDEFINED,
+					VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 0, VK_ACCESS_TRANSFER_WRITE_BIT));
+			}
+			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, (uint32_t)barriers.size(), barriers.data());
+
+			for (size_t i = begin; i < end; i++)
+			{
+				const PendingUpload& upload = m_PendingUploads[i];
+				vkCmdCopyBufferToImage(commandBuffer, upload.Buffer, upload.Image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, upload.RegionCount, &m_PendingRegions[upload.FirstRegion]);
+			}
+
+			barriers.clear();
+			for (size_t i = begin; i < end; i++)
+			{
+				barriers.push_back(imageBarrier(m_PendingUploads[i].Image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+					VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT));
+			}
+			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, (uint32_t)barriers.size(), barriers.data());
+
+			uploadedImages.insert(uploadedImages.end(), segmentImages.begin(), segmentImages.end());
+			begin = end;
+		}
+
+		m_PendingUploads.clear();
+		m_PendingRegions.clear();
+
+		MarkSubmitted(timelineValue);
+	}
+
+	void UploadQueue::Submit(VkQueue queue)
+	{
+		if (!HasPendingUploads())
+			return;
+
+		Reclaim();
+
+		// Reuse a command buffer the GPU is done with
+		auto it = std::find_if(m_CommandBuffers.begin(), m_CommandBuffers.end(), [](const CommandBuffer& commandBuffer)
+		{
+			return GPUTimeline::IsComplete(commandBuffer.TimelineValue);
+		});
+
+		if (it == m_CommandBuffers.end())
+		{
+			VkCommandBufferAllocateInfo allocInfo = {};
+			allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			allocInfo.commandPool = m_CommandPool;
+			allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+			allocInfo.commandBufferCount = 1;
+
+			CommandBuffer& commandBuffer = m_CommandBuffers.emplace_back();
+			VkResult err = vkAllocateCommandBuffers(m_Device, &allocInfo, &commandBuffer.Handle);
+			check_vk_result(err);
+			it = m_CommandBuffers.end() - 1;
+		}
+
+		VkCommandBufferBeginInfo beginInfo = {};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		VkResult err = vkBeginCommandBuffer(it->Handle, &beginInfo);
+		check_vk_result(err);
+
+		const uint64_t timelineValue = GPUTimeline::GetPendingValue();
+		Record(it->Handle, timelineValue);
+
+		err = vkEndCommandBuffer(it->Handle);
+		check_vk_result(err);
+
+		it->TimelineValue = GPUTimeline::BeginSubmission();
+
+		VkSemaphore timelineSemaphore = GPUTimeline::GetSemaphore();
+		VkTimelineSemaphoreSubmitInfo timelineInfo = {};
+		timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+		timelineInfo.signalSemaphoreValueCount = 1;
+		timelineInfo.pSignalSemaphoreValues = &it->TimelineValue;
+
+		VkSubmitInfo submitInfo = {};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.pNext = &timelineInfo;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &it->Handle;
+		submitInfo.signalSemaphoreCount = 1;
+		submitInfo.pSignalSemaphores = &timelineSemaphore;
+		err = vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE);
+		check_vk_result(err);
+	}
+
+	void UploadQueue::MarkSubmitted(uint64_t timelineValue)
+	{
+		if (m_Head != m_SubmittedHead)
+		{
+			m_InFlightRanges.push_back({ timelineValue, m_Head });
+			m_SubmittedHead = m_Head;
+		}
+
+		for (DedicatedBuffer& dedicated : m_DedicatedBuffers)
+		{
+			if (dedicated.TimelineValue == 0)
+				dedicated.TimelineValue = timelineValue;
+		}
+	}
+
+	void UploadQueue::Reclaim()
+	{
+		const uint64_t completedValue = GPUTimeline::GetCompletedValue();
+
+		while (!m_InFlightRanges.empty() && m_InFlightRanges.front().TimelineValue <= completedValue)
+		{
+			m_Tail = m_InFlightRanges.front().End;
+			m_InFlightRanges.pop_front();
+		}
+
+		std::erase_if(m_DedicatedBuffers, [&](const DedicatedBuffer& dedicated)
+		{
+			if (dedicated.TimelineValue == 0 || dedicated.TimelineValue > completedValue)
+				return false;
+
+			vkDestroyBuffer(m_Device, dedicated.Buffer, nullptr);
+			MemoryAllocator::Free(dedicated.Allocation);
+			return true;
+		});
+	}
+
+}
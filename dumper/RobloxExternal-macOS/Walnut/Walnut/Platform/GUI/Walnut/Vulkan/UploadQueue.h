@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include "vulkan/vulkan.h"
+
+#include "MemoryAllocator.h"
+
+namespace Walnut {
+
+	struct StagingAllocation
+	{
+		VkBuffer Buffer = VK_NULL_HANDLE;
+		VkDeviceSize Offset = 0;
+		VkDeviceSize Size = 0;
+
+		// Persistently mapped and host coherent, write the upload data here
+		void* Data = nullptr;
+
+		bool IsValid() const { return Data != nullptr; }
+	};
+
+	//
+	// Batched, non-blocking texture uploads
+	//
+	// Staging memory comes from a persistently mapped ring buffer. Pending copies are recorded
+	// at the start of the next frame's command buffer, and every staging region is tagged with
+	// the GPUTimeline value of that submission so it is reused as soon as the GPU is done with it.
+	// The CPU only waits on the GPU when the ring is full. Main thread only.
+	//
+	class UploadQueue
+	{
+	public:
+		UploadQueue(VkDevice device, uint32_t queueFamily, VkDeviceSize ringSize);
+		~UploadQueue();
+
+		UploadQueue(const UploadQueue&) = delete;
+
+		// Valid until the upload has been recorded. Requests larger than
+		// the ring get a dedicated buffer that is freed after the upload.
+		// Check IsValid(), a dedicated buffer can fail to allocate.
+		StagingAllocation AllocateStaging(VkDeviceSize size, VkDeviceSize alignment = 16);
+
+		// Region buffer offsets are relative to staging.Offset.
+		// Without preserveContents the parts of the image outside the regions become undefined.
+		void UploadToImage(const StagingAllocation& staging, VkImage image, const VkBufferImageCopy* regions, uint32_t regionCount, bool preserveContents);
+
+		bool HasPendingUploads() const { return !m_PendingUploads.empty(); }
+
+		// Records all pending uploads into commandBuffer, which must signal timelineValue.
+		// Called by the Application at the start of every frame, outside the render pass.
+		void Record(VkCommandBuffer commandBuffer, uint64_t timelineValue);
+
+		// Submits pending uploads on their own, for when no frame is rendered (eg. minimized)
+		void Submit(VkQueue queue);
+	private:
+		void Reclaim();
+		StagingAllocation AllocateDedicated(VkDeviceSize size);
+		void MarkSubmitted(uint64_t timelineValue);
+	private:
+		struct PendingUpload
+		{
+			VkBuffer Buffer;
+			VkImage Image;
+			bool PreserveContents;
+			uint32_t FirstRegion;
+			uint32_t RegionCount;
+		};
+
+		struct InFlightRange
+		{
+			uint64_t TimelineValue;
+			uint64_t End;
+		};
+
+		struct DedicatedBuffer
+		{
+			VkBuffer Buffer = VK_NULL_HANDLE;
+			MemoryAllocation Allocation;
+			uint64_t TimelineValue = 0;
+		};
+
+		struct CommandBuffer
+		{
+			VkCommandBuffer Handle = VK_NULL_HANDLE;
+			uint64_t TimelineValue = 0;
+		};
+
+		VkDevice m_Device = VK_NULL_HANDLE;
+
+		VkBuffer m_RingBuffer = VK_NULL_HANDLE;
+		MemoryAllocation m_RingAllocation;
+		uint8_t* m_RingData = nullptr;
+		VkDeviceSize m_RingSize = 0;
+
+		// Monotonic offsets, the ring position is offset % m_RingSize.
+		// [m_Tail, m_SubmittedHead) is in flight on the GPU, [m_SubmittedHead, m_Head) is pending.
+		uint64_t m_Head = 0;
+		uint64_t m_SubmittedHead = 0;
+		uint64_t m_Tail = 0;
+		std::deque<InFlightRange> m_InFlightRanges;
+
+		std::vector<DedicatedBuffer> m_DedicatedBuffers;
+
+		std::vector<PendingUpload> m_PendingUploads;
+		std::vector<VkBufferImageCopy> m_PendingRegions;
+
+		// For Submit()
+		VkCommandPool m_CommandPool = VK_NULL_HANDLE;
+		std::vector<CommandBuffer> m_CommandBuffers;
+	};
+
+}
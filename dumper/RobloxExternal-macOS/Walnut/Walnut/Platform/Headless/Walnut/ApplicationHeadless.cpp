@@ -1,6 +1,10 @@
 #include "ApplicationHeadless.h"
 
 #include "Walnut/Core/Log.h"
+#include "Walnut/Core/Profiler.h"
+#include "Walnut/Core/AllocationTracker.h"
+
+#include <glm/glm.hpp>
 
 #include <iostream>
 #include <chrono>
@@ -9,6 +13,9 @@ extern bool g_ApplicationRunning;
 
 static Walnut::Application* s_Instance = nullptr;
 
+// Set between the Shutdown of a restarting application and the Init of the next one
+static bool s_Restarting = false;
+
 namespace Walnut {
 
 	Application::Application(const ApplicationSpecification& specification)
@@ -33,8 +40,15 @@ namespace Walnut {
 
 	void Application::Init()
 	{
-		// Intialize logging
-		Log::Init(m_Specification.Name);
+		// Loggers are still up after a soft restart
+		if (!s_Restarting)
+			Log::Init(m_Specification.Name, m_Specification.LogRingBufferSize);
+		s_Restarting = false;
+
+		WL_PROFILE_THREAD("Main");
+
+		m_JobSystem = std::make_unique<JobSystem>(m_Specification.WorkerThreadCount);
+		m_JobSystem->SetMainThreadWakeCallback([this]() { WakeMainLoop(); });
 	}
 
 	void Application::Shutdown()
@@ -44,6 +58,15 @@ namespace Walnut {
 
 		m_LayerStack.clear();
 
+		// Finish outstanding jobs before the resources they use go away
+		m_JobSystem.reset();
+
+		if (m_RestartRequested)
+		{
+			s_Restarting = true;
+			return;
+		}
+
 		g_ApplicationRunning = false;
 
 		Log::Shutdown();
@@ -53,18 +76,48 @@ namespace Walnut {
 	{
 		m_Running = true;
 
+		const bool fixedRate = m_Specification.TickRate > 0.0;
+		if (fixedRate)
+		{
+			m_TickScheduler.SetRate(m_Specification.TickRate);
+			m_TickScheduler.SetOverrunPolicy(m_Specification.OverrunPolicy);
+			m_TickScheduler.SetMaxCatchUpTicks(m_Specification.MaxCatchUpTicks);
+			m_TimeStep = std::chrono::duration<float>(m_TickScheduler.GetPeriod()).count();
+		}
+		else
+		{
+			// Tick every SleepDuration milliseconds, measured from the start of each tick.
+			// Updates that take longer run back-to-back instead of catching up.
+			m_TickScheduler.SetPeriod(std::chrono::milliseconds(m_Specification.SleepDuration));
+			m_TickScheduler.SetOverrunPolicy(TickOverrunPolicy::Reset);
+		}
+
+		m_TickScheduler.Start();
+
 		// Main loop
 		while (m_Running)
 		{
+			m_EventQueue.Execute();
+			m_JobSystem->ExecuteMainThreadJobs();
+
+			// Woken early by Close(), a queued event or a main-thread job
+			if (!m_TickScheduler.WaitForNextTick())
+				continue;
+
+			WL_PROFILE_FRAME();
+			WL_ALLOCATION_FRAME();
+
 			for (auto& layer : m_LayerStack)
+			{
+				WL_PROFILE_SCOPE(Profiler::GetMemberZoneName(typeid(*layer), "OnUpdate"));
 				layer->OnUpdate(m_TimeStep);
+			}
 
-			if (m_Specification.SleepDuration > 0)
-				std::this_thread::sleep_for(std::chrono::milliseconds(m_Specification.SleepDuration));
-
-			float time = GetTime();
-			m_FrameTime = time - m_LastFrameTime;
-			m_TimeStep = glm::min<float>(m_FrameTime, 0.0333f);
+			// Only the difference goes to floating point, so the timestep stays exact regardless of uptime
+			const int64_t time = GetTimeNs();
+			m_FrameTime = (float)Clock::ToSeconds(time - m_LastFrameTime);
+			if (!fixedRate)
+				m_TimeStep = glm::min<float>(m_FrameTime, 0.0333f);
 			m_LastFrameTime = time;
 		}
 
@@ -73,11 +126,23 @@ namespace Walnut {
 	void Application::Close()
 	{
 		m_Running = false;
+		WakeMainLoop();
+	}
+
+	void Application::Restart()
+	{
+		m_RestartRequested = true;
+		Close();
+	}
+
+	void Application::WakeMainLoop()
+	{
+		m_TickScheduler.Wake();
 	}
 
 	float Application::GetTime()
 	{
-		return m_AppTimer.Elapsed();
+		return (float)GetTimeSeconds();
 	}
 
 }
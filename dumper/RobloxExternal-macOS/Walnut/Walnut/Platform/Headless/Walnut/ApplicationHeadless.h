@@ -2,6 +2,9 @@
 
 #include "Walnut/Layer.h"
 #include "Walnut/Timer.h"
+#include "Walnut/TickScheduler.h"
+#include "Walnut/Core/JobSystem.h"
+#include "Walnut/Core/EventQueue.h"
 
 #include <string>
 #include <vector>
@@ -16,7 +19,22 @@ namespace Walnut {
 		uint32_t Width = 1600;
 		uint32_t Height = 900;
 
+		// Tick period in milliseconds when TickRate is 0
 		uint64_t SleepDuration = 500;
+
+		// Fixed update rate in Hz, 0 = tick every SleepDuration milliseconds.
+		// With a tick rate the timestep is the exact tick period.
+		double TickRate = 0.0;
+		TickOverrunPolicy OverrunPolicy = TickOverrunPolicy::Skip;
+		uint32_t MaxCatchUpTicks = 5;
+
+		// Worker threads of the application JobSystem,
+		// 0 = one per hardware thread minus the main thread
+		uint32_t WorkerThreadCount = 0;
+
+		// Size in bytes of the crash-safe log ring buffer
+		// that replaces the log files, 0 keeps the files
+		uint64_t LogRingBufferSize = 0;
 	};
 
 	class Application
@@ -43,20 +61,48 @@ namespace Walnut {
 
 		void Close();
 
+		// Ends Run like Close, after which Walnut::Main creates the application again
+		// with the loggers kept alive (see the GUI Application::Restart)
+		void Restart();
+
+		// Thread-safe, runs func on the main thread before the next update
+		template<typename Func>
+		void QueueEvent(Func&& func)
+		{
+			// Only the event that makes the queue non-empty has to wake the loop
+			if (m_EventQueue.Push(std::forward<Func>(func)))
+				WakeMainLoop();
+		}
+
+		// Thread-safe, ends the current wait for the next tick
+		void WakeMainLoop();
+
+		// Time since the application started. Keep long spans in GetTimeNs, the float
+		// version loses precision after a few days of uptime.
+		int64_t GetTimeNs() const { return m_AppTimer.ElapsedNanoseconds(); }
+		double GetTimeSeconds() const { return m_AppTimer.ElapsedSeconds(); }
 		float GetTime();
+
+		JobSystem& GetJobSystem() { return *m_JobSystem; }
 	private:
 		void Init();
 		void Shutdown();
 	private:
 		ApplicationSpecification m_Specification;
 		bool m_Running = false;
+		bool m_RestartRequested = false;
 
 		float m_TimeStep = 0.0f;
 		float m_FrameTime = 0.0f;
-		float m_LastFrameTime = 0.0f;
+		int64_t m_LastFrameTime = 0;
 
 		std::vector<std::shared_ptr<Layer>> m_LayerStack;
 		Timer m_AppTimer;
+
+		TickScheduler m_TickScheduler;
+		EventQueue m_EventQueue;
+
+		std::unique_ptr<JobSystem> m_JobSystem;
 	};
 
 	// Implemented by CLIENT
@@ -0,0 +1,433 @@
+#include "AllocationTracker.h"
+
+#include "Profiler.h"
+
+#include "Walnut/Timer.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <format>
+#include <fstream>
+#include <limits>
+#include <mutex>
+#include <new>
+
+#ifdef _WIN32
+	#include <malloc.h>
+#endif
+
+namespace Walnut {
+
+	namespace {
+
+		// In front of every block, the padding up to the block's alignment holds it
+		struct BlockHeader
+		{
+			uint64_t Size;
+
+			// From the start of the underlying malloc block to the user pointer
+			uint32_t Offset;
+
+			uint16_t Tag;
+			uint16_t Tracked;
+		};
+
+		static_assert(sizeof(BlockHeader) == 16, "BlockHeader must keep blocks 16 byte aligned");
+
+		struct TagCounters
+		{
+			std::atomic<uint64_t> Allocations;
+			std::atomic<uint64_t> AllocatedBytes;
+			std::atomic<uint64_t> Frees;
+			std::atomic<uint64_t> FreedBytes;
+		};
+
+		struct alignas(64) ThreadCounters
+		{
+			TagCounters Tags[AllocationTracker::MaxTags];
+		};
+
+		struct TagTotals
+		{
+			uint64_t Allocations = 0;
+			uint64_t AllocatedBytes = 0;
+			uint64_t Frees = 0;
+			uint64_t FreedBytes = 0;
+		};
+
+		// Zero-initialized static storage, so allocations made before static constructors run are counted too.
+		// Slots aren't released when their thread exits (that would need a TLS destructor, which may allocate),
+		// threads beyond the last slot share it with atomic adds.
+		ThreadCounters s_ThreadCounters[AllocationTracker::MaxThreads];
+		std::atomic<uint32_t> s_NextThreadSlot = 0;
+
+		thread_local ThreadCounters* s_Counters = nullptr;
+		thread_local bool s_SharedCounters = false;
+
+		ThreadCounters& GetThreadCounters()
+		{
+			if (!s_Counters)
+			{
+				const uint32_t slot = s_NextThreadSlot.fetch_add(1, std::memory_order_relaxed);
+				s_SharedCounters = slot >= AllocationTracker::MaxThreads - 1;
+				s_Counters = &s_ThreadCounters[std::min(slot, AllocationTracker::MaxThreads - 1)];
+			}
+
+			return *s_Counters;
+		}
+
+		// Only the owning thread writes to its slot, so a plain load and store is enough
+		void Add(std::atomic<uint64_t>& counter, uint64_t value)
+		{
+			if (s_SharedCounters)
+				counter.fetch_add(value, std::memory_order_relaxed);
+			else
+				counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+		}
+
+		void* AlignedMalloc(size_t size, size_t alignment)
+		{
+#ifdef _WIN32
+			return _aligned_malloc(size, alignment);
+#else
+			void* ptr = nullptr;
+			return posix_memalign(&ptr, alignment, size) == 0 ? ptr : nullptr;
+#endif
+		}
+
+		void AlignedFree(void* ptr)
+		{
+#ifdef _WIN32
+			_aligned_free(ptr);
+#else
+			std::free(ptr);
+#endif
+		}
+
+		struct TagRegistry
+		{
+			std::mutex Mutex;
+			std::atomic<const char*> Names[AllocationTracker::MaxTags] = { "Untagged" };
+			std::atomic<uint32_t> Count = 1;
+		};
+
+		TagRegistry& GetTagRegistry()
+		{
+			static TagRegistry registry;
+			return registry;
+		}
+
+		struct FrameState
+		{
+			std::mutex Mutex;
+			uint64_t FrameCount = 0;
+
+			// Totals at the last MarkFrame
+			TagTotals Previous[AllocationTracker::MaxTags];
+			TagTotals Frame[AllocationTracker::MaxTags];
+
+			// Totals at the start of the current rate window
+			TagTotals RateStart[AllocationTracker::MaxTags];
+			int64_t RateStartTime = 0;
+			double Rates[AllocationTracker::MaxTags] = {};
+
+			uint32_t History[AllocationTracker::FrameHistoryCapacity] = {};
+		};
+
+		FrameState& GetFrameState()
+		{
+			static FrameState state;
+			return state;
+		}
+
+		void SumCounters(TagTotals* totals, uint32_t tagCount)
+		{
+			const uint32_t threadCount = std::min(s_NextThreadSlot.load(std::memory_order_relaxed), AllocationTracker::MaxThreads);
+			for (uint32_t thread = 0; thread < threadCount; thread++)
+			{
+				const ThreadCounters& counters = s_ThreadCounters[thread];
+				for (uint32_t tag = 0; tag < tagCount; tag++)
+				{
+					const TagCounters& tagCounters = counters.Tags[tag];
+					totals[tag].Allocations += tagCounters.Allocations.load(std::memory_order_relaxed);
+					totals[tag].AllocatedBytes += tagCounters.AllocatedBytes.load(std::memory_order_relaxed);
+					totals[tag].Frees += tagCounters.Frees.load(std::memory_order_relaxed);
+					totals[tag].FreedBytes += tagCounters.FreedBytes.load(std::memory_order_relaxed);
+				}
+			}
+		}
+
+		std::string FormatBytes(int64_t bytes)
+		{
+			const double absBytes = (double)(bytes < 0 ? -bytes : bytes);
+			if (absBytes >= 1024.0 * 1024.0 * 1024.0)
+				return std::format("{:.2f} GB", bytes / (1024.0 * 1024.0 * 1024.0));
+			if (absBytes >= 1024.0 * 1024.0)
+				return std::format("{:.2f} MB", bytes / (1024.0 * 1024.0));
+			if (absBytes >= 1024.0)
+				return std::format("{:.2f} KB", bytes / 1024.0);
+			return std::format("{} B", bytes);
+		}
+
+	}
+
+	uint16_t AllocationTracker::RegisterTag(std::string_view name)
+	{
+		TagRegistry& registry = GetTagRegistry();
+		std::scoped_lock<std::mutex> lock(registry.Mutex);
+
+		const uint32_t count = registry.Count.load(std::memory_order_relaxed);
+		for (uint32_t tag = 0; tag < count; tag++)
+		{
+			if (name == registry.Names[tag].load(std::memory_order_relaxed))
+				return (uint16_t)tag;
+		}
+
+		if (count == MaxTags)
+			return 0;
+
+		registry.Names[count].store(Profiler::InternString(name), std::memory_order_relaxed);
+		registry.Count.store(count + 1, std::memory_order_release);
+		return (uint16_t)count;
+	}
+
+	void AllocationTracker::MarkFrame()
+	{
+		if (!IsAvailable())
+			return;
+
+		const uint32_t tagCount = GetTagRegistry().Count.load(std::memory_order_acquire);
+
+		TagTotals totals[MaxTags];
+		SumCounters(totals, tagCount);
+
+		FrameState& state = GetFrameState();
+		std::scoped_lock<std::mutex> lock(state.Mutex);
+
+		// The first mark only sets the baseline, there is no complete frame before it
+		uint64_t frameAllocations = 0;
+		for (uint32_t tag = 0; tag < tagCount; tag++)
+		{
+			TagTotals& frame = state.Frame[tag];
+			const TagTotals& previous = state.Previous[tag];
+			const bool first = state.FrameCount == 0;
+
+			frame.Allocations = first ? 0 : totals[tag].Allocations - previous.Allocations;
+			frame.AllocatedBytes = first ? 0 : totals[tag].AllocatedBytes - previous.AllocatedBytes;
+			frame.Frees = first ? 0 : totals[tag].Frees - previous.Frees;
+			frame.FreedBytes = first ? 0 : totals[tag].FreedBytes - previous.FreedBytes;
+			frameAllocations += frame.Allocations;
+
+			state.Previous[tag] = totals[tag];
+		}
+
+		state.History[state.FrameCount % FrameHistoryCapacity] = (uint32_t)std::min<uint64_t>(frameAllocations, std::numeric_limits<uint32_t>::max());
+		state.FrameCount++;
+
+		const int64_t now = Clock::Now();
+		if (state.RateStartTime == 0 || now - state.RateStartTime >= Clock::FromSeconds(1.0))
+		{
+			const double seconds = Clock::ToSeconds(now - state.RateStartTime);
+			for (uint32_t tag = 0; tag < tagCount; tag++)
+			{
+				state.Rates[tag] = state.RateStartTime == 0 ? 0.0 : (totals[tag].Allocations - state.RateStart[tag].Allocations) / seconds;
+				state.RateStart[tag] = totals[tag];
+			}
+			state.RateStartTime = now;
+		}
+	}
+
+	AllocationStats AllocationTracker::GetStats()
+	{
+		AllocationStats stats;
+		stats.Total.Name = "Total";
+		if (!IsAvailable())
+			return stats;
+
+		TagRegistry& registry = GetTagRegistry();
+		const uint32_t tagCount = registry.Count.load(std::memory_order_acquire);
+
+		TagTotals totals[MaxTags];
+		SumCounters(totals, tagCount);
+
+		FrameState& state = GetFrameState();
+		std::scoped_lock<std::mutex> lock(state.Mutex);
+
+		stats.Tags.resize(tagCount);
+		for (uint32_t tag = 0; tag < tagCount; tag++)
+		{
+			AllocationTagStats& tagStats = stats.Tags[tag];
+			tagStats.Name = registry.Names[tag].load(std::memory_order_relaxed);
+			tagStats.LiveBytes = (int64_t)(totals[tag].AllocatedBytes - totals[tag].FreedBytes);
+			tagStats.LiveCount = (int64_t)(totals[tag].Allocations - totals[tag].Frees);
+			tagStats.TotalAllocations = totals[tag].Allocations;
+			tagStats.TotalBytes = totals[tag].AllocatedBytes;
+			tagStats.FrameAllocations = state.Frame[tag].Allocations;
+			tagStats.FrameBytes = state.Frame[tag].AllocatedBytes;
+			tagStats.AllocationRate = state.Rates[tag];
+
+			stats.Total.LiveBytes += tagStats.LiveBytes;
+			stats.Total.LiveCount += tagStats.LiveCount;
+			stats.Total.TotalAllocations += tagStats.TotalAllocations;
+			stats.Total.TotalBytes += tagStats.TotalBytes;
+			stats.Total.FrameAllocations += tagStats.FrameAllocations;
+			stats.Total.FrameBytes += tagStats.FrameBytes;
+			stats.Total.AllocationRate += tagStats.AllocationRate;
+		}
+
+		stats.FrameCount = state.FrameCount;
+
+		const uint64_t historyCount = std::min<uint64_t>(state.FrameCount, FrameHistoryCapacity);
+		stats.FrameHistory.reserve(historyCount);
+		for (uint64_t frame = state.FrameCount - historyCount; frame < state.FrameCount; frame++)
+			stats.FrameHistory.push_back(state.History[frame % FrameHistoryCapacity]);
+
+		return stats;
+	}
+
+	bool AllocationTracker::DumpToFile(const std::filesystem::path& filepath)
+	{
+		return DumpToFile(GetStats(), filepath);
+	}
+
+	bool AllocationTracker::DumpToFile(const AllocationStats& stats, const std::filesystem::path& filepath)
+	{
+		std::ofstream stream(filepath);
+		if (!stream)
+			return false;
+
+		if (!IsAvailable())
+		{
+			stream << "Allocation tracking is not compiled in (WL_TRACK_ALLOCATIONS)\n";
+			return (bool)stream;
+		}
+
+		std::vector<const AllocationTagStats*> tags;
+		tags.reserve(stats.Tags.size());
+		for (const AllocationTagStats& tag : stats.Tags)
+			tags.push_back(&tag);
+
+		std::sort(tags.begin(), tags.end(), [](const AllocationTagStats* a, const AllocationTagStats* b) { return a->LiveBytes > b->LiveBytes; });
+		tags.push_back(&stats.Total);
+
+		stream << std::format("Walnut allocation report after {} frames\n\n", stats.FrameCount);
+		stream << std::format("{:<24} {:>12} {:>12} {:>14} {:>12} {:>12} {:>12} {:>12}\n",
+			"Tag", "Live", "Live count", "Allocations", "Allocated", "Frame", "Frame bytes", "Per second");
+
+		for (const AllocationTagStats* tag : tags)
+		{
+			stream << std::format("{:<24} {:>12} {:>12} {:>14} {:>12} {:>12} {:>12} {:>12.0f}\n",
+				tag->Name ? tag->Name : "", FormatBytes(tag->LiveBytes), tag->LiveCount, tag->TotalAllocations,
+				FormatBytes((int64_t)tag->TotalBytes), tag->FrameAllocations, FormatBytes((int64_t)tag->FrameBytes), tag->AllocationRate);
+		}
+
+		return (bool)stream;
+	}
+
+	void* AllocationTracker::Allocate(size_t size, size_t alignment) noexcept
+	{
+		// The header sits in the padding in front of the block
+		const size_t offset = std::max(alignment, sizeof(BlockHeader));
+		if (offset > std::numeric_limits<uint32_t>::max() || size > std::numeric_limits<size_t>::max() - offset)
+			return nullptr;
+
+		uint8_t* base = (uint8_t*)(offset == sizeof(BlockHeader) ? std::malloc(size + offset) : AlignedMalloc(size + offset, offset));
+		if (!base)
+			return nullptr;
+
+		const uint16_t tag = s_CurrentTag < MaxTags ? s_CurrentTag : 0;
+		const bool tracked = IsEnabled();
+
+		BlockHeader* header = (BlockHeader*)(base + offset) - 1;
+		header->Size = size;
+		header->Offset = (uint32_t)offset;
+		header->Tag = tag;
+		header->Tracked = tracked;
+
+		if (tracked)
+		{
+			TagCounters& counters = GetThreadCounters().Tags[tag];
+			Add(counters.Allocations, 1);
+			Add(counters.AllocatedBytes, size);
+		}
+
+		return base + offset;
+	}
+
+	void AllocationTracker::Free(void* ptr) noexcept
+	{
+		if (!ptr)
+			return;
+
+		const BlockHeader* header = (const BlockHeader*)ptr - 1;
+		if (header->Tracked)
+		{
+			TagCounters& counters = GetThreadCounters().Tags[header->Tag];
+			Add(counters.Frees, 1);
+			Add(counters.FreedBytes, header->Size);
+		}
+
+		uint8_t* base = (uint8_t*)ptr - header->Offset;
+		if (header->Offset == sizeof(BlockHeader))
+			std::free(base);
+		else
+			AlignedFree(base);
+	}
+
+}
+
+#if WL_TRACK_ALLOCATIONS
+
+namespace {
+
+	void* AllocateOrThrow(std::size_t size, std::size_t alignment)
+	{
+		for (;;)
+		{
+			if (void* ptr = Walnut::AllocationTracker::Allocate(size, alignment))
+				return ptr;
+
+			std::new_handler handler = std::get_new_handler();
+			if (!handler)
+				throw std::bad_alloc();
+			handler();
+		}
+	}
+
+	void* AllocateOrNull(std::size_t size, std::size_t alignment) noexcept
+	{
+		try
+		{
+			return AllocateOrThrow(size, alignment);
+		}
+		catch (...)
+		{
+			return nullptr;
+		}
+	}
+
+}
+
+void* operator new(std::size_t size) { return AllocateOrThrow(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__); }
+void* operator new[](std::size_t size) { return AllocateOrThrow(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return AllocateOrNull(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return AllocateOrNull(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__); }
+void* operator new(std::size_t size, std::align_val_t alignment) { return AllocateOrThrow(size, (std::size_t)alignment); }
+void* operator new[](std::size_t size, std::align_val_t alignment) { return AllocateOrThrow(size, (std::size_t)alignment); }
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept { return AllocateOrNull(size, (std::size_t)alignment); }
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept { return AllocateOrNull(size, (std::size_t)alignment); }
+
+void operator delete(void* ptr) noexcept { Walnut::AllocationTracker::Free(ptr); }
+void operator delete[](void* ptr) noexcept { Walnut::AllocationTracker::Free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { Walnut::AllocationTracker::Free(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { Walnut::AllocationTracker::Free(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { Walnut::AllocationTracker::Free(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { Walnut::AllocationTracker::Free(ptr); }
+void operator delete(void* ptr, std::align_val_t) noexcept { Walnut::AllocationTracker::Free(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept { Walnut::AllocationTracker::Free(ptr); }
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept { Walnut::AllocationTracker::Free(ptr); }
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept { Walnut::AllocationTracker::Free(ptr); }
+void operator delete(void* ptr, std::align_val_t, const std::nothrow_t&) noexcept { Walnut::AllocationTracker::Free(ptr); }
+void operator delete[](void* ptr, std::align_val_t, const std::nothrow_t&) noexcept { Walnut::AllocationTracker::Free(ptr); }
+
+#endif
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string_view>
+#include <vector>
+
+// Off by default: tracking replaces the global operator new/delete and adds a small header
+// to every allocation. Define as 1 for the whole program (CMake option WL_TRACK_ALLOCATIONS).
+#ifndef WL_TRACK_ALLOCATIONS
+	#define WL_TRACK_ALLOCATIONS 0
+#endif
+
+namespace Walnut {
+
+	struct AllocationTagStats
+	{
+		const char* Name = nullptr;
+
+		// Currently allocated
+		int64_t LiveBytes = 0;
+		int64_t LiveCount = 0;
+
+		// Since startup
+		uint64_t TotalAllocations = 0;
+		uint64_t TotalBytes = 0;
+
+		// During the last complete frame
+		uint64_t FrameAllocations = 0;
+		uint64_t FrameBytes = 0;
+
+		// Allocations per second, averaged over the last second
+		double AllocationRate = 0.0;
+	};
+
+	struct AllocationStats
+	{
+		// Indexed by tag, tag 0 is everything allocated outside an AllocationScope
+		std::vector<AllocationTagStats> Tags;
+		AllocationTagStats Total;
+
+		uint64_t FrameCount = 0;
+
+		// Allocations of the most recent frames, oldest first
+		std::vector<uint32_t> FrameHistory;
+	};
+
+	//
+	// Global heap allocation tracker
+	//
+	// Every allocation is counted in per-thread counters under the tag of the innermost
+	// AllocationScope on its thread, so the hot path is a few plain stores with no locks.
+	// The tag and size are kept in a header in front of the block, frees are credited to
+	// the tag the block was allocated with no matter which thread releases it.
+	//
+	class AllocationTracker
+	{
+	public:
+		static constexpr uint32_t MaxTags = 64;
+		static constexpr uint32_t MaxThreads = 128;
+		static constexpr uint32_t FrameHistoryCapacity = 256;
+	public:
+		// False when built without WL_TRACK_ALLOCATIONS, all stats are zero then
+		static constexpr bool IsAvailable() { return WL_TRACK_ALLOCATIONS != 0; }
+
+		// Blocks allocated while disabled are never counted, not even when freed later
+		static void SetEnabled(bool enabled) { s_Enabled.store(enabled, std::memory_order_relaxed); }
+		static bool IsEnabled() { return s_Enabled.load(std::memory_order_relaxed); }
+
+		// Thread-safe, returns the same tag for the same name.
+		// Returns 0 (untagged) once MaxTags is reached.
+		static uint16_t RegisterTag(std::string_view name);
+
+		// Called by the Application main loop at the start of every frame
+		static void MarkFrame();
+
+		static AllocationStats GetStats();
+
+		// Human readable report, tags sorted by live bytes
+		static bool DumpToFile(const std::filesystem::path& filepath);
+		static bool DumpToFile(const AllocationStats& stats, const std::filesystem::path& filepath);
+
+		// Used by the operator new/delete replacements, nullptr when out of memory
+		static void* Allocate(size_t size, size_t alignment) noexcept;
+		static void Free(void* ptr) noexcept;
+	private:
+		inline static std::atomic<bool> s_Enabled = true;
+		inline static thread_local uint16_t s_CurrentTag = 0;
+
+		friend class AllocationScope;
+	};
+
+	class AllocationScope
+	{
+	public:
+		AllocationScope(uint16_t tag)
+			: m_PreviousTag(AllocationTracker::s_CurrentTag)
+		{
+			AllocationTracker::s_CurrentTag = tag;
+		}
+
+		~AllocationScope()
+		{
+			AllocationTracker::s_CurrentTag = m_PreviousTag;
+		}
+
+		AllocationScope(const AllocationScope&) = delete;
+		AllocationScope& operator=(const AllocationScope&) = delete;
+	private:
+		uint16_t m_PreviousTag;
+	};
+
+}
+
+#if WL_TRACK_ALLOCATIONS
+	#define WL_ALLOCATION_CONCAT_INTERNAL(a, b) a##b
+	#define WL_ALLOCATION_CONCAT(a, b) WL_ALLOCATION_CONCAT_INTERNAL(a, b)
+
+	// The tag is registered once per call site
+	#define WL_ALLOCATION_SCOPE(name) \
+		static const uint16_t WL_ALLOCATION_CONCAT(wlAllocationTag, __LINE__) = ::Walnut::AllocationTracker::RegisterTag(name); \
+		::Walnut::AllocationScope WL_ALLOCATION_CONCAT(wlAllocationScope, __LINE__)(WL_ALLOCATION_CONCAT(wlAllocationTag, __LINE__))
+	#define WL_ALLOCATION_FRAME() ::Walnut::AllocationTracker::MarkFrame()
+#else
+	#define WL_ALLOCATION_SCOPE(name)
+	#define WL_ALLOCATION_FRAME()
+#endif
@@ -0,0 +1,456 @@
+#include "BinaryLog.h"
+
+#include <chrono>
+#include <ctime>
+#include <cmath>
+#include <functional>
+#include <thread>
+
+#ifdef _WIN32
+	#include <Windows.h>
+#elif __APPLE__
+	#include <pthread.h>
+#elif __linux__
+	#include <unistd.h>
+	#include <sys/syscall.h>
+#endif
+
+namespace Walnut {
+
+	namespace BinaryLog {
+
+		uint64_t GetTimestamp()
+		{
+			return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+		}
+
+		static uint64_t QueryThreadID()
+		{
+#ifdef _WIN32
+			return (uint64_t)::GetCurrentThreadId();
+#elif __APPLE__
+			uint64_t threadID = 0;
+			pthread_threadid_np(nullptr, &threadID);
+			return threadID;
+#elif __linux__
+			return (uint64_t)::syscall(SYS_gettid);
+#else
+			return (uint64_t)std::hash<std::thread::id>()(std::this_thread::get_id());
+#endif
+		}
+
+		uint64_t GetThreadID()
+		{
+			thread_local uint64_t s_ThreadID = QueryThreadID();
+			return s_ThreadID;
+		}
+
+	}
+
+	//==============================================================================
+	/// BinaryLogWriter
+	BinaryLogWriter::BinaryLogWriter(const std::filesystem::path& filepath, size_t bufferSize)
+		: m_BufferSize(bufferSize)
+	{
+		m_Stream = std::ofstream(filepath, std::ofstream::out | std::ofstream::binary | std::ofstream::trunc);
+		m_Buffer.reserve(m_BufferSize + 1024);
+
+		m_Buffer.insert(m_Buffer.end(), std::begin(BinaryLog::Magic), std::end(BinaryLog::Magic));
+		WriteRaw(BinaryLog::Version);
+		WriteRaw<uint16_t>(0);
+		WriteRaw(BinaryLog::GetTimestamp());
+		FlushBuffer();
+	}
+
+	BinaryLogWriter::~BinaryLogWriter()
+	{
+		Flush();
+		m_Stream.close();
+	}
+
+	void BinaryLogWriter::Flush()
+	{
+		std::scoped_lock<std::mutex> lock(m_Mutex);
+		FlushBuffer();
+		m_Stream.flush();
+	}
+
+	void BinaryLogWriter::FlushBuffer()
+	{
+		if (m_Buffer.empty())
+			return;
+
+		m_Stream.write((const char*)m_Buffer.data(), m_Buffer.size());
+		m_Buffer.clear();
+	}
+
+	uint32_t BinaryLogWriter::GetFormatID(uint8_t loggerType, uint8_t level, std::string_view tag, std::string_view format)
+	{
+		auto it = m_FormatIDs.find(FormatKeyView(format.data(), tag, loggerType, level));
+		if (it != m_FormatIDs.end())
+			return it->second;
+
+		const uint32_t id = (uint32_t)m_FormatIDs.size();
+		m_FormatIDs.emplace(FormatKey{ format.data(), std::string(tag), loggerType, level }, id);
+
+		WriteRaw(BinaryLog::RecordKind::Format);
+		WriteRaw(id);
+		WriteRaw(loggerType);
+		WriteRaw(level);
+		WriteRaw<uint16_t>((uint16_t)tag.size());
+		m_Buffer.insert(m_Buffer.end(), tag.begin(), tag.end());
+		WriteString(format);
+
+		return id;
+	}
+
+	//==============================================================================
+	/// BinaryLogReader
+	namespace Utils {
+
+		template<typename T>
+		static bool ReadRaw(std::istream& stream, T& value)
+		{
+			stream.read((char*)&value, sizeof(T));
+			return (size_t)stream.gcount() == sizeof(T);
+		}
+
+		static bool ReadString(std::istream& stream, std::string& string, size_t size, uint64_t streamSize)
+		{
+			// Check against what is left of the stream before allocating
+			const std::streamoff position = stream.tellg();
+			if (position < 0 || size > streamSize - (uint64_t)position)
+				return false;
+
+			string.resize(size);
+			stream.read(string.data(), size);
+			return (size_t)stream.gcount() == size;
+		}
+
+		template<typename T>
+		static bool ReadRaw(std::string_view& data, T& value)
+		{
+			if (data.size() < sizeof(T))
+				return false;
+
+			memcpy(&value, data.data(), sizeof(T));
+			data.remove_prefix(sizeof(T));
+			return true;
+		}
+
+		static void AppendJSONString(std::string& out, std::string_view string)
+		{
+			out += '"';
+			for (char c : string)
+			{
+				switch (c)
+				{
+					case '"':  out += "\\\""; break;
+					case '\\': out += "\\\\"; break;
+					case '\n': out += "\\n"; break;
+					case '\r': out += "\\r"; break;
+					case '\t': out += "\\t"; break;
+					default:
+						if ((unsigned char)c < 0x20)
+							out += std::format("\\u{:04x}", (int)c);
+						else
+							out += c;
+						break;
+				}
+			}
+			out += '"';
+		}
+
+		static std::string FormatArg(const BinaryLogReader::Arg& arg, std::string_view spec)
+		{
+			const std::string fmt = std::format("{{:{}}}", spec);
+			return std::visit([&fmt](const auto& value) -> std::string
+			{
+				try
+				{
+					return std::vformat(fmt, std::make_format_args(value));
+				}
+				catch (const std::format_error&)
+				{
+					return std::vformat("{}", std::make_format_args(value));
+				}
+			}, arg);
+		}
+
+	}
+
+	BinaryLogReader::BinaryLogReader(const std::filesystem::path& filepath)
+	{
+		m_Stream = std::ifstream(filepath, std::ifstream::in | std::ifstream::binary);
+		if (!m_Stream)
+			return;
+
+		std::error_code error;
+		m_FileSize = std::filesystem::file_size(filepath, error);
+		if (error)
+			return;
+
+		char magic[4];
+		uint16_t version, reserved;
+		m_Stream.read(magic, sizeof(magic));
+		if (m_Stream.gcount() != sizeof(magic) || memcmp(magic, BinaryLog::Magic, sizeof(magic)) != 0)
+			return;
+
+		if (!Utils::ReadRaw(m_Stream, version) || version != BinaryLog::Version)
+			return;
+
+		if (!Utils::ReadRaw(m_Stream, reserved) || !Utils::ReadRaw(m_Stream, m_StartTime))
+			return;
+
+		m_Valid = true;
+	}
+
+	bool BinaryLogReader::ReadNext(Entry& outEntry)
+	{
+		if (!m_Valid)
+			return false;
+
+		BinaryLog::RecordKind kind;
+		while (Utils::ReadRaw(m_Stream, kind))
+		{
+			if (kind == BinaryLog::RecordKind::Format)
+			{
+				uint32_t id;
+				uint16_t tagSize;
+				uint32_t formatSize;
+				FormatInfo info;
+				if (!Utils::ReadRaw(m_Stream, id) || !Utils::ReadRaw(m_Stream, info.LoggerType) || !Utils::ReadRaw(m_Stream, info.Level))
+					return false;
+				if (!Utils::ReadRaw(m_Stream, tagSize) || !Utils::ReadString(m_Stream, info.Tag, tagSize, m_FileSize))
+					return false;
+				if (!Utils::ReadRaw(m_Stream, formatSize) || !Utils::ReadString(m_Stream, info.Format, formatSize, m_FileSize))
+					return false;
+
+				m_Formats[id] = std::move(info);
+			}
+			else if (kind == BinaryLog::RecordKind::Event)
+			{
+				uint32_t id, payloadSize;
+				if (!Utils::ReadRaw(m_Stream, id) || !Utils::ReadRaw(m_Stream, outEntry.Timestamp) || !Utils::ReadRaw(m_Stream, outEntry.ThreadID))
+					return false;
+
+				std::string payload;
+				if (!Utils::ReadRaw(m_Stream, payloadSize) || !Utils::ReadString(m_Stream, payload, payloadSize, m_FileSize))
+					return false;
+
+				auto it = m_Formats.find(id);
+				if (it == m_Formats.end())
+					return false;
+
+				outEntry.Format = &it->second;
+				return ReadArgs(payload, outEntry.Args);
+			}
+			else
+			{
+				return false;
+			}
+		}
+
+		return false;
+	}
+
+	bool BinaryLogReader::ReadArgs(std::string_view payload, std::vector<Arg>& outArgs)
+	{
+		outArgs.clear();
+
+		uint8_t count;
+		if (!Utils::ReadRaw(payload, count))
+			return false;
+
+		for (uint8_t i = 0; i < count; i++)
+		{
+			BinaryLog::ArgType type;
+			if (!Utils::ReadRaw(payload, type))
+				return false;
+
+			switch (type)
+			{
+				case BinaryLog::ArgType::Int64:
+				{
+					int64_t value;
+					if (!Utils::ReadRaw(payload, value)) return false;
+					outArgs.emplace_back(value);
+					break;
+				}
+				case BinaryLog::ArgType::UInt64:
+				{
+					uint64_t value;
+					if (!Utils::ReadRaw(payload, value)) return false;
+					outArgs.emplace_back(value);
+					break;
+				}
+				case BinaryLog::ArgType::Double:
+				{
+					double value;
+					if (!Utils::ReadRaw(payload, value)) return false;
+					outArgs.emplace_back(value);
+					break;
+				}
+				case BinaryLog::ArgType::Bool:
+				{
+					uint8_t value;
+					if (!Utils::ReadRaw(payload, value)) return false;
+					outArgs.emplace_back(value != 0);
+					break;
+				}
+				case BinaryLog::ArgType::Char:
+				{
+					char value;
+					if (!Utils::ReadRaw(payload, value)) return false;
+					outArgs.emplace_back(value);
+					break;
+				}
+				case BinaryLog::ArgType::String:
+				{
+					uint32_t size;
+					if (!Utils::ReadRaw(payload, size) || payload.size() < size) return false;
+					outArgs.emplace_back(std::string(payload.substr(0, size)));
+					payload.remove_prefix(size);
+					break;
+				}
+				case BinaryLog::ArgType::Pointer:
+				{
+					uint64_t value;
+					if (!Utils::ReadRaw(payload, value)) return false;
+					outArgs.emplace_back((const void*)(uintptr_t)value);
+					break;
+				}
+				default:
+					return false;
+			}
+		}
+
+		return true;
+	}
+
+	std::string BinaryLogReader::FormatMessage(const Entry& entry)
+	{
+		// Re-applies the format string one replacement field at a time,
+		// since the argument count/types are only known at runtime
+		std::string result;
+		const std::string_view format = entry.Format->Format;
+		size_t nextArg = 0;
+
+		for (size_t i = 0; i < format.size(); i++)
+		{
+			const char c = format[i];
+			if (c == '{' && i + 1 < format.size() && format[i + 1] == '{')
+			{
+				result += '{';
+				i++;
+				continue;
+			}
+			if (c == '}' && i + 1 < format.size() && format[i + 1] == '}')
+			{
+				result += '}';
+				i++;
+				continue;
+			}
+			if (c != '{')
+			{
+				result += c;
+				continue;
+			}
+
+			const size_t end = format.find('}', i);
+			if (end == std::string_view::npos)
+			{
+				result += format.substr(i);
+				break;
+			}
+
+			std::string_view field = format.substr(i + 1, end - i - 1);
+			std::string_view spec;
+			if (const size_t colon = field.find(':'); colon != std::string_view::npos)
+			{
+				spec = field.substr(colon + 1);
+				field = field.substr(0, colon);
+			}
+
+			size_t argIndex = nextArg++;
+			if (!field.empty())
+			{
+				argIndex = 0;
+				for (char digit : field)
+					argIndex = argIndex * 10 + (size_t)(digit - '0');
+			}
+
+			if (argIndex < entry.Args.size())
+				result += Utils::FormatArg(entry.Args[argIndex], spec);
+			else
+				result += format.substr(i, end - i + 1);
+
+			i = end;
+		}
+
+		return result;
+	}
+
+	std::string BinaryLogReader::ToJSON(const Entry& entry)
+	{
+		std::string json = std::format("{{\"timestamp\":{},\"thread\":{},\"logger\":\"{}\",\"level\":\"{}\",\"tag\":",
+			entry.Timestamp, entry.ThreadID, entry.Format->LoggerType == 0 ? "WALNUT" : "APP", LevelToString(entry.Format->Level));
+		Utils::AppendJSONString(json, entry.Format->Tag);
+		json += ",\"format\":";
+		Utils::AppendJSONString(json, entry.Format->Format);
+		json += ",\"message\":";
+		Utils::AppendJSONString(json, FormatMessage(entry));
+		json += ",\"args\":[";
+		for (size_t i = 0; i < entry.Args.size(); i++)
+		{
+			if (i > 0)
+				json += ',';
+
+			std::visit([&json](const auto& value)
+			{
+				using Type = std::decay_t<decltype(value)>;
+				if constexpr (std::is_same_v<Type, std::string>)
+					Utils::AppendJSONString(json, value);
+				else if constexpr (std::is_same_v<Type, char>)
+					Utils::AppendJSONString(json, std::string_view(&value, 1));
+				else if constexpr (std::is_same_v<Type, const void*>)
+					Utils::AppendJSONString(json, std::format("{}", value));
+				else if constexpr (std::is_same_v<Type, double>)
+					json += std::isfinite(value) ? std::format("{}", value) : "null";
+				else
+					json += std::format("{}", value);
+			}, entry.Args[i]);
+		}
+		json += "]}";
+		return json;
+	}
+
+	std::string BinaryLogReader::FormatTimestamp(uint64_t timestamp)
+	{
+		const time_t seconds = (time_t)(timestamp / 1000000000ull);
+		const uint64_t micros = (timestamp % 1000000000ull) / 1000ull;
+
+		std::tm time{};
+#ifdef _WIN32
+		localtime_s(&time, &seconds);
+#else
+		localtime_r(&seconds, &time);
+#endif
+		return std::format("{:02}:{:02}:{:02}.{:06}", time.tm_hour, time.tm_min, time.tm_sec, micros);
+	}
+
+	const char* BinaryLogReader::LevelToString(uint8_t level)
+	{
+		// Log::Level values, named like spdlog's %l so decoded lines match the text file sinks
+		switch (level)
+		{
+			case 0: return "trace";
+			case 1: return "info";
+			case 2: return "warning";
+			case 3: return "error";
+			case 4: return "critical";
+		}
+		return "";
+	}
+
+}
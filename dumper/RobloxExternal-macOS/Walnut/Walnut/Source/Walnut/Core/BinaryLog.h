@@ -0,0 +1,260 @@
+#pragma once
+
+//
+// Binary structured logging
+//
+// Instead of formatting text on the hot path, each log call is stored as a format-string ID,
+// a timestamp, the thread ID and the raw argument bytes. Format strings are written once per
+// call site. Logs are turned back into text/JSON offline by BinaryLogReader (see Walnut-LogDecoder).
+//
+// File layout (little-endian):
+//   Header:  "WLBL" | u16 version | u16 reserved | i64 start time (ns since epoch)
+//   Format:  u8 RecordKind::Format | u32 id | u8 logger type | u8 level | u16 tag size | tag | u32 format size | format
+//   Event:   u8 RecordKind::Event  | u32 id | i64 timestamp (ns since epoch) | u64 thread id | u32 payload size | payload
+//   Payload: u8 arg count, then per arg: u8 ArgType | value (strings are u32 size | bytes)
+//
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+#include <filesystem>
+#include <fstream>
+#include <type_traits>
+#include <variant>
+#include <format>
+
+namespace Walnut {
+
+	namespace BinaryLog {
+
+		constexpr char Magic[4] = { 'W', 'L', 'B', 'L' };
+		constexpr uint16_t Version = 1;
+
+		enum class RecordKind : uint8_t
+		{
+			Format = 1, Event = 2
+		};
+
+		enum class ArgType : uint8_t
+		{
+			Int64 = 0, UInt64, Double, Bool, Char, String, Pointer
+		};
+
+		uint64_t GetTimestamp();
+		uint64_t GetThreadID();
+
+	}
+
+	class BinaryLogWriter
+	{
+	public:
+		BinaryLogWriter(const std::filesystem::path& filepath, size_t bufferSize = 64 * 1024);
+		BinaryLogWriter(const BinaryLogWriter&) = delete;
+		~BinaryLogWriter();
+
+		bool IsOpen() const { return m_Stream.is_open(); }
+
+		template<typename... Args>
+		void Write(uint8_t loggerType, uint8_t level, std::string_view tag, std::string_view format, const Args&... args)
+		{
+			const uint64_t timestamp = BinaryLog::GetTimestamp();
+			const uint64_t threadID = BinaryLog::GetThreadID();
+
+			std::scoped_lock<std::mutex> lock(m_Mutex);
+
+			const uint32_t formatID = GetFormatID(loggerType, level, tag, format);
+
+			WriteRaw(BinaryLog::RecordKind::Event);
+			WriteRaw(formatID);
+			WriteRaw(timestamp);
+			WriteRaw(threadID);
+
+			// Payload size is patched once the arguments are encoded
+			const size_t payloadSizeOffset = m_Buffer.size();
+			WriteRaw<uint32_t>(0);
+			const size_t payloadStart = m_Buffer.size();
+
+			WriteRaw<uint8_t>((uint8_t)sizeof...(Args));
+			(EncodeArg(args), ...);
+
+			const uint32_t payloadSize = (uint32_t)(m_Buffer.size() - payloadStart);
+			memcpy(m_Buffer.data() + payloadSizeOffset, &payloadSize, sizeof(uint32_t));
+
+			if (m_Buffer.size() >= m_BufferSize)
+				FlushBuffer();
+		}
+
+		void Flush();
+	private:
+		uint32_t GetFormatID(uint8_t loggerType, uint8_t level, std::string_view tag, std::string_view format);
+		void FlushBuffer();
+
+		template<typename T>
+		void WriteRaw(const T& value)
+		{
+			static_assert(std::is_trivially_copyable_v<T>);
+			const size_t offset = m_Buffer.size();
+			m_Buffer.resize(offset + sizeof(T));
+			memcpy(m_Buffer.data() + offset, &value, sizeof(T));
+		}
+
+		void WriteString(std::string_view string)
+		{
+			WriteRaw<uint32_t>((uint32_t)string.size());
+			m_Buffer.insert(m_Buffer.end(), string.begin(), string.end());
+		}
+
+		template<typename T>
+		void EncodeArg(const T& arg)
+		{
+			using Type = std::decay_t<T>;
+
+			if constexpr (std::is_same_v<Type, bool>)
+			{
+				WriteRaw(BinaryLog::ArgType::Bool);
+				WriteRaw<uint8_t>(arg ? 1 : 0);
+			}
+			else if constexpr (std::is_same_v<Type, char>)
+			{
+				WriteRaw(BinaryLog::ArgType::Char);
+				WriteRaw(arg);
+			}
+			else if constexpr (std::is_integral_v<Type> && std::is_signed_v<Type>)
+			{
+				WriteRaw(BinaryLog::ArgType::Int64);
+				WriteRaw<int64_t>(arg);
+			}
+			else if constexpr (std::is_integral_v<Type>)
+			{
+				WriteRaw(BinaryLog::ArgType::UInt64);
+				WriteRaw<uint64_t>(arg);
+			}
+			else if constexpr (std::is_floating_point_v<Type>)
+			{
+				WriteRaw(BinaryLog::ArgType::Double);
+				WriteRaw<double>(arg);
+			}
+			else if constexpr (std::is_convertible_v<const T&, std::string_view>)
+			{
+				WriteRaw(BinaryLog::ArgType::String);
+				WriteString(std::string_view(arg));
+			}
+			else if constexpr (std::is_pointer_v<Type>)
+			{
+				WriteRaw(BinaryLog::ArgType::Pointer);
+				WriteRaw<uint64_t>((uint64_t)(uintptr_t)arg);
+			}
+			else
+			{
+				// Anything else (eg. glm types) has no raw encoding, so store its text form
+				WriteRaw(BinaryLog::ArgType::String);
+				WriteString(std::format("{}", arg));
+			}
+		}
+	private:
+		std::mutex m_Mutex;
+		std::ofstream m_Stream;
+		std::vector<uint8_t> m_Buffer;
+		size_t m_BufferSize;
+
+		// Format strings are literals, so their address identifies the call site.
+		// Tags may be runtime strings, so they are compared by content.
+		struct FormatKey
+		{
+			const char* Format = nullptr;
+			std::string Tag;
+			uint8_t LoggerType = 0;
+			uint8_t Level = 0;
+		};
+
+		// Lets GetFormatID look up a runtime tag without copying it into a std::string
+		struct FormatKeyView
+		{
+			const char* Format;
+			std::string_view Tag;
+			uint8_t LoggerType;
+			uint8_t Level;
+
+			FormatKeyView(const char* format, std::string_view tag, uint8_t loggerType, uint8_t level)
+				: Format(format), Tag(tag), LoggerType(loggerType), Level(level) {}
+			FormatKeyView(const FormatKey& key)
+				: Format(key.Format), Tag(key.Tag), LoggerType(key.LoggerType), Level(key.Level) {}
+
+			bool operator==(const FormatKeyView& other) const
+			{
+				return Format == other.Format && LoggerType == other.LoggerType && Level == other.Level && Tag == other.Tag;
+			}
+		};
+
+		struct FormatKeyHash
+		{
+			using is_transparent = void;
+
+			size_t operator()(const FormatKeyView& key) const
+			{
+				size_t hash = std::hash<const void*>()(key.Format);
+				hash ^= std::hash<std::string_view>()(key.Tag) + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2);
+				hash ^= (size_t)(key.LoggerType << 8 | key.Level) * 0xff51afd7ed558ccdull;
+				return hash;
+			}
+		};
+
+		struct FormatKeyEqual
+		{
+			using is_transparent = void;
+
+			bool operator()(const FormatKeyView& a, const FormatKeyView& b) const { return a == b; }
+		};
+
+		std::unordered_map<FormatKey, uint32_t, FormatKeyHash, FormatKeyEqual> m_FormatIDs;
+	};
+
+	class BinaryLogReader
+	{
+	public:
+		using Arg = std::variant<int64_t, uint64_t, double, bool, char, std::string, const void*>;
+
+		struct FormatInfo
+		{
+			uint8_t LoggerType = 0;
+			uint8_t Level = 0;
+			std::string Tag;
+			std::string Format;
+		};
+
+		struct Entry
+		{
+			const FormatInfo* Format = nullptr;
+			uint64_t Timestamp = 0;
+			uint64_t ThreadID = 0;
+			std::vector<Arg> Args;
+		};
+	public:
+		BinaryLogReader(const std::filesystem::path& filepath);
+
+		bool IsValid() const { return m_Valid; }
+		uint64_t GetStartTime() const { return m_StartTime; }
+
+		// Returns false at end of file or on a truncated/corrupt record
+		bool ReadNext(Entry& outEntry);
+
+		static std::string FormatMessage(const Entry& entry);
+		static std::string ToJSON(const Entry& entry);
+		static std::string FormatTimestamp(uint64_t timestamp);
+		static const char* LevelToString(uint8_t level);
+	private:
+		bool ReadArgs(std::string_view payload, std::vector<Arg>& outArgs);
+	private:
+		std::ifstream m_Stream;
+		// Bounds the sizes read from records, so a corrupt file can't trigger huge allocations
+		uint64_t m_FileSize = 0;
+		bool m_Valid = false;
+		uint64_t m_StartTime = 0;
+		std::unordered_map<uint32_t, FormatInfo> m_Formats;
+	};
+
+}
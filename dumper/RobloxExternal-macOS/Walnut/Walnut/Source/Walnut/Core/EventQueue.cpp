@@ -0,0 +1,96 @@
+#include "EventQueue.h"
+
+namespace Walnut {
+
+	//
+	// Node recycling
+	//
+	// Executed nodes go back to a free list shared by all queues: the consumer returns its
+	// whole batch with a single CAS. Producers never pop single nodes off the shared list
+	// (that is open to ABA), they swap out the whole list into a thread-local cache and
+	// allocate from there.
+	//
+	struct EventQueue::NodeCache
+	{
+		Node* First = nullptr;
+
+		~NodeCache()
+		{
+			while (First)
+			{
+				Node* next = First->Next;
+				delete First;
+				First = next;
+			}
+		}
+	};
+
+	std::atomic<EventQueue::Node*> EventQueue::s_FreeNodes = nullptr;
+	thread_local EventQueue::NodeCache EventQueue::s_NodeCache;
+
+	EventQueue::Node* EventQueue::AllocateNode()
+	{
+		if (!s_NodeCache.First)
+			s_NodeCache.First = s_FreeNodes.exchange(nullptr, std::memory_order_acquire);
+
+		Node* node = s_NodeCache.First;
+		if (!node)
+			return new Node();
+
+		s_NodeCache.First = node->Next;
+		node->Next = nullptr;
+		return node;
+	}
+
+	void EventQueue::RecycleNodes(Node* first, Node* last)
+	{
+		Node* head = s_FreeNodes.load(std::memory_order_relaxed);
+		do
+		{
+			last->Next = head;
+		} while (!s_FreeNodes.compare_exchange_weak(head, first, std::memory_order_release, std::memory_order_relaxed));
+	}
+
+	EventQueue::~EventQueue()
+	{
+		Node* node = m_Head.exchange(nullptr, std::memory_order_acquire);
+		while (node)
+		{
+			Node* next = node->Next;
+			delete node;
+			node = next;
+		}
+	}
+
+	uint32_t EventQueue::Execute()
+	{
+		Node* batch = m_Head.exchange(nullptr, std::memory_order_acquire);
+		if (!batch)
+			return 0;
+
+		// The list is newest first, reverse it to run in submission order
+		Node* last = batch;
+		Node* ordered = nullptr;
+		while (batch)
+		{
+			Node* next = batch->Next;
+			batch->Next = ordered;
+			ordered = batch;
+			batch = next;
+		}
+
+		uint32_t count = 0;
+		for (Node* node = ordered; node; node = node->Next)
+		{
+			node->Function();
+
+			// Release captures now rather than when the node is reused
+			node->Function.Reset();
+			count++;
+		}
+
+		RecycleNodes(ordered, last);
+		return count;
+	}
+
+}
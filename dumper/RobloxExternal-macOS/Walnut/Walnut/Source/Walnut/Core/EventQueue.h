@@ -0,0 +1,176 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace Walnut {
+
+	//
+	// Move-only void() callable with small buffer storage.
+	// Callables up to InlineSize bytes (most capturing lambdas) are stored
+	// in place, larger ones fall back to a heap allocation.
+	//
+	class Task
+	{
+	public:
+		static constexpr size_t InlineSize = 48;
+	public:
+		Task() = default;
+
+		template<typename Func, typename = std::enable_if_t<!std::is_same_v<std::decay_t<Func>, Task>>>
+		Task(Func&& func)
+		{
+			using FuncType = std::decay_t<Func>;
+			if constexpr (IsInline<FuncType>())
+			{
+				new (m_Storage) FuncType(std::forward<Func>(func));
+				m_VTable = &s_InlineVTable<FuncType>;
+			}
+			else
+			{
+				*reinterpret_cast<FuncType**>(m_Storage) = new FuncType(std::forward<Func>(func));
+				m_VTable = &s_HeapVTable<FuncType>;
+			}
+		}
+
+		Task(Task&& other) noexcept
+		{
+			MoveFrom(other);
+		}
+
+		Task& operator=(Task&& other) noexcept
+		{
+			if (this != &other)
+			{
+				Reset();
+				MoveFrom(other);
+			}
+			return *this;
+		}
+
+		Task(const Task&) = delete;
+		Task& operator=(const Task&) = delete;
+
+		~Task() { Reset(); }
+
+		void operator()() { m_VTable->Invoke(m_Storage); }
+		explicit operator bool() const { return m_VTable != nullptr; }
+
+		void Reset()
+		{
+			if (m_VTable)
+			{
+				m_VTable->Destroy(m_Storage);
+				m_VTable = nullptr;
+			}
+		}
+	private:
+		struct VTable
+		{
+			void (*Invoke)(void* storage);
+			void (*Move)(void* destination, void* source);
+			void (*Destroy)(void* storage);
+		};
+
+		template<typename FuncType>
+		static constexpr bool IsInline()
+		{
+			return sizeof(FuncType) <= InlineSize && alignof(FuncType) <= alignof(std::max_align_t)
+				&& std::is_nothrow_move_constructible_v<FuncType>;
+		}
+
+		template<typename FuncType>
+		static constexpr VTable s_InlineVTable = {
+			[](void* storage) { (*std::launder(reinterpret_cast<FuncType*>(storage)))(); },
+			[](void* destination, void* source)
+			{
+				FuncType* func = std::launder(reinterpret_cast<FuncType*>(source));
+				new (destination) FuncType(std::move(*func));
+				func->~FuncType();
+			},
+			[](void* storage) { std::launder(reinterpret_cast<FuncType*>(storage))->~FuncType(); }
+		};
+
+		template<typename FuncType>
+		static constexpr VTable s_HeapVTable = {
+			[](void* storage) { (**reinterpret_cast<FuncType**>(storage))(); },
+			[](void* destination, void* source) { *reinterpret_cast<FuncType**>(destination) = *reinterpret_cast<FuncType**>(source); },
+			[](void* storage) { delete *reinterpret_cast<FuncType**>(storage); }
+		};
+
+		void MoveFrom(Task& other)
+		{
+			if (other.m_VTable)
+			{
+				other.m_VTable->Move(m_Storage, other.m_Storage);
+				m_VTable = other.m_VTable;
+				other.m_VTable = nullptr;
+			}
+		}
+	private:
+		alignas(std::max_align_t) std::byte m_Storage[InlineSize];
+		const VTable* m_VTable = nullptr;
+	};
+
+	//
+	// Lock-free multi-producer, single-consumer queue of Tasks
+	//
+	// Producers push onto an atomic list head with a single CAS and never wait on the consumer.
+	// The consumer swaps out the whole list at once and runs that batch in submission order;
+	// tasks pushed while a batch runs go to the next batch.
+	// List nodes are recycled, so steady-state pushes don't allocate (see EventQueue.cpp).
+	//
+	class EventQueue
+	{
+	public:
+		EventQueue() = default;
+		EventQueue(const EventQueue&) = delete;
+
+		// Drops tasks that were never executed
+		~EventQueue();
+
+		// Thread-safe. Returns true if the queue was empty, ie. the consumer may need waking.
+		template<typename Func>
+		bool Push(Func&& func)
+		{
+			Node* node = AllocateNode();
+			node->Function = Task(std::forward<Func>(func));
+
+			Node* head = m_Head.load(std::memory_order_relaxed);
+			do
+			{
+				node->Next = head;
+			} while (!m_Head.compare_exchange_weak(head, node, std::memory_order_release, std::memory_order_relaxed));
+
+			return head == nullptr;
+		}
+
+		// Consumer thread only. Runs the current batch and returns the number of tasks executed.
+		uint32_t Execute();
+
+		bool IsEmpty() const { return m_Head.load(std::memory_order_relaxed) == nullptr; }
+	private:
+		struct Node
+		{
+			Task Function;
+			Node* Next = nullptr;
+		};
+		struct NodeCache;
+
+		static Node* AllocateNode();
+
+		// Returns the executed chain first..last to the free list
+		static void RecycleNodes(Node* first, Node* last);
+
+		// Most recently pushed first
+		std::atomic<Node*> m_Head = nullptr;
+
+		static std::atomic<Node*> s_FreeNodes;
+		static thread_local NodeCache s_NodeCache;
+	};
+
+}
@@ -0,0 +1,279 @@
+#include "JobSystem.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <string>
+
+namespace Walnut {
+
+	// Job system and worker index of the current thread, -1 for non-worker threads
+	static thread_local const JobSystem* s_CurrentJobSystem = nullptr;
+	static thread_local uint32_t s_CurrentWorkerIndex = (uint32_t)-1;
+
+	JobSystem::JobSystem(uint32_t workerCount)
+		: m_MainThreadID(std::this_thread::get_id())
+	{
+		if (workerCount == 0)
+			workerCount = std::max(2u, std::thread::hardware_concurrency()) - 1;
+
+		m_Workers.reserve(workerCount);
+		for (uint32_t i = 0; i < workerCount; i++)
+			m_Workers.emplace_back(std::make_unique<Worker>());
+
+		for (uint32_t i = 0; i < workerCount; i++)
+			m_Workers[i]->Thread = std::thread(&JobSystem::WorkerThreadFunc, this, i);
+	}
+
+	JobSystem::~JobSystem()
+	{
+		m_Running = false;
+		m_WorkSignal.fetch_add(1, std::memory_order_release);
+		m_WorkSignal.notify_all();
+
+		for (auto& worker : m_Workers)
+			worker->Thread.join();
+	}
+
+	JobHandle JobSystem::Submit(Job job, std::initializer_list<JobHandle> dependencies)
+	{
+		return SubmitInternal(std::move(job), dependencies.begin(), dependencies.size(), false);
+	}
+
+	JobHandle JobSystem::Submit(Job job, const std::vector<JobHandle>& dependencies)
+	{
+		return SubmitInternal(std::move(job), dependencies.data(), dependencies.size(), false);
+	}
+
+	JobHandle JobSystem::SubmitMainThread(Job job, std::initializer_list<JobHandle> dependencies)
+	{
+		return SubmitInternal(std::move(job), dependencies.begin(), dependencies.size(), true);
+	}
+
+	JobHandle JobSystem::SubmitMainThread(Job job, const std::vector<JobHandle>& dependencies)
+	{
+		return SubmitInternal(std::move(job), dependencies.data(), dependencies.size(), true);
+	}
+
+	JobHandle JobSystem::SubmitInternal(Job job, const JobHandle* dependencies, size_t dependencyCount, bool mainThread)
+	{
+		JobPtr node = std::make_shared<Internal::JobNode>();
+		node->Function = std::move(job);
+		node->MainThread = mainThread;
+
+		for (size_t i = 0; i < dependencyCount; i++)
+		{
+			const JobPtr& dependency = dependencies[i].m_Node;
+			if (!dependency)
+				continue;
+
+			std::scoped_lock<std::mutex> lock(dependency->ContinuationMutex);
+			if (dependency->Finished.load(std::memory_order_acquire))
+				continue;
+
+			node->PendingDependencies.fetch_add(1, std::memory_order_relaxed);
+			dependency->Continuations.push_back(node);
+		}
+
+		// Drop the setup reference, schedules right away if there is nothing to wait on
+		if (node->PendingDependencies.fetch_sub(1, std::memory_order_acq_rel) == 1)
+			Schedule(node);
+
+		return JobHandle(node);
+	}
+
+	void JobSystem::Schedule(JobPtr job)
+	{
+		if (job->MainThread)
+		{
+			{
+				std::scoped_lock<std::mutex> lock(m_MainThreadQueueMutex);
+				m_MainThreadQueue.push_back(std::move(job));
+			}
+
+			if (m_MainThreadWakeCallback)
+				m_MainThreadWakeCallback();
+			return;
+		}
+
+		// Workers push to their own queue, other threads spread jobs round-robin
+		uint32_t queueIndex = s_CurrentWorkerIndex;
+		if (s_CurrentJobSystem != this)
+			queueIndex = m_NextQueue.fetch_add(1, std::memory_order_relaxed) % (uint32_t)m_Workers.size();
+
+		{
+			Worker& worker = *m_Workers[queueIndex];
+			std::scoped_lock<std::mutex> lock(worker.QueueMutex);
+			worker.Queue.push_back(std::move(job));
+		}
+
+		m_WorkSignal.fetch_add(1, std::memory_order_release);
+		m_WorkSignal.notify_one();
+	}
+
+	void JobSystem::Execute(const JobPtr& job)
+	{
+		{
+			WL_PROFILE_SCOPE(job->MainThread ? "MainThreadJob" : "Job");
+			job->Function();
+		}
+		job->Function = nullptr;
+
+		std::vector<JobPtr> continuations;
+		{
+			std::scoped_lock<std::mutex> lock(job->ContinuationMutex);
+			job->Finished.store(true, std::memory_order_release);
+			continuations.swap(job->Continuations);
+		}
+
+		for (JobPtr& continuation : continuations)
+		{
+			if (continuation->PendingDependencies.fetch_sub(1, std::memory_order_acq_rel) == 1)
+				Schedule(std::move(continuation));
+		}
+	}
+
+	JobSystem::JobPtr JobSystem::PopOrSteal(uint32_t workerIndex)
+	{
+		const uint32_t workerCount = (uint32_t)m_Workers.size();
+
+		// Own queue first (LIFO, keeps caches warm)
+		if (workerIndex < workerCount)
+		{
+			Worker& worker = *m_Workers[workerIndex];
+			std::scoped_lock<std::mutex> lock(worker.QueueMutex);
+			if (!worker.Queue.empty())
+			{
+				JobPtr job = std::move(worker.Queue.back());
+				worker.Queue.pop_back();
+				return job;
+			}
+		}
+
+		// Then steal the oldest job of another worker (FIFO)
+		const uint32_t start = workerIndex < workerCount ? workerIndex + 1 : 0;
+		for (uint32_t i = 0; i < workerCount; i++)
+		{
+			Worker& victim = *m_Workers[(start + i) % workerCount];
+			std::scoped_lock<std::mutex> lock(victim.QueueMutex);
+			if (victim.Queue.empty())
+				continue;
+
+			JobPtr job = std::move(victim.Queue.front());
+			victim.Queue.pop_front();
+			return job;
+		}
+
+		return nullptr;
+	}
+
+	bool JobSystem::TryRunOne()
+	{
+		const uint32_t workerIndex = s_CurrentJobSystem == this ? s_CurrentWorkerIndex : (uint32_t)-1;
+		JobPtr job = PopOrSteal(workerIndex);
+		if (!job)
+			return false;
+
+		Execute(job);
+		return true;
+	}
+
+	void JobSystem::ParallelFor(uint32_t count, uint32_t batchSize, const std::function<void(uint32_t)>& func)
+	{
+		if (count == 0)
+			return;
+
+		batchSize = std::max(1u, batchSize);
+		const uint32_t batchCount = (count + batchSize - 1) / batchSize;
+
+		// A handful of jobs pull batches from a shared counter instead of one job per batch
+		std::atomic<uint32_t> nextBatch = 0;
+		auto runBatches = [&]()
+		{
+			uint32_t batch;
+			while ((batch = nextBatch.fetch_add(1, std::memory_order_relaxed)) < batchCount)
+			{
+				const uint32_t begin = batch * batchSize;
+				const uint32_t end = std::min(begin + batchSize, count);
+				for (uint32_t i = begin; i < end; i++)
+					func(i);
+			}
+		};
+
+		const uint32_t helperCount = std::min(GetWorkerCount(), batchCount - 1);
+		std::vector<JobHandle> helpers;
+		helpers.reserve(helperCount);
+		for (uint32_t i = 0; i < helperCount; i++)
+			helpers.push_back(Submit(runBatches));
+
+		runBatches();
+		Wait(helpers);
+	}
+
+	void JobSystem::Wait(const JobHandle& handle)
+	{
+		// Main-thread jobs (or jobs depending on them) only finish if the main thread runs them
+		const bool mainThread = std::this_thread::get_id() == m_MainThreadID;
+
+		while (!handle.IsFinished())
+		{
+			if (mainThread)
+				ExecuteMainThreadJobs();
+
+			if (!TryRunOne())
+				std::this_thread::yield();
+		}
+	}
+
+	void JobSystem::Wait(const std::vector<JobHandle>& handles)
+	{
+		for (const JobHandle& handle : handles)
+			Wait(handle);
+	}
+
+	void JobSystem::ExecuteMainThreadJobs()
+	{
+		std::vector<JobPtr> jobs;
+		{
+			std::scoped_lock<std::mutex> lock(m_MainThreadQueueMutex);
+			jobs.swap(m_MainThreadQueue);
+		}
+
+		for (const JobPtr& job : jobs)
+			Execute(job);
+	}
+
+	bool JobSystem::IsWorkerThread() const
+	{
+		return s_CurrentJobSystem == this;
+	}
+
+	void JobSystem::WorkerThreadFunc(uint32_t workerIndex)
+	{
+		s_CurrentJobSystem = this;
+		s_CurrentWorkerIndex = workerIndex;
+
+		WL_PROFILE_THREAD("Worker " + std::to_string(workerIndex));
+
+		while (true)
+		{
+			// Read the signal before looking for work so a push in between is never missed
+			const uint32_t signal = m_WorkSignal.load(std::memory_order_acquire);
+
+			if (JobPtr job = PopOrSteal(workerIndex))
+			{
+				Execute(job);
+				continue;
+			}
+
+			// Queues are drained before shutting down
+			if (!m_Running.load(std::memory_order_acquire))
+				break;
+
+			m_WorkSignal.wait(signal, std::memory_order_acquire);
+		}
+
+		s_CurrentJobSystem = nullptr;
+		s_CurrentWorkerIndex = (uint32_t)-1;
+	}
+
+}
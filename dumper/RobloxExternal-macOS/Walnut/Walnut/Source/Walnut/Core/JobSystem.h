@@ -0,0 +1,128 @@
+#pragma once
+
+#include <cstdint>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Walnut {
+
+	class JobSystem;
+
+	namespace Internal {
+
+		struct JobNode
+		{
+			std::function<void()> Function;
+			bool MainThread = false;
+
+			// Dependencies not finished yet, +1 while the job is still being set up
+			std::atomic<uint32_t> PendingDependencies = 1;
+			std::atomic<bool> Finished = false;
+
+			std::mutex ContinuationMutex;
+			std::vector<std::shared_ptr<JobNode>> Continuations;
+		};
+
+	}
+
+	// Handle to a submitted job, usable as a dependency of later jobs
+	class JobHandle
+	{
+	public:
+		JobHandle() = default;
+
+		bool IsValid() const { return (bool)m_Node; }
+		bool IsFinished() const { return !m_Node || m_Node->Finished.load(std::memory_order_acquire); }
+	private:
+		JobHandle(std::shared_ptr<Internal::JobNode> node)
+			: m_Node(std::move(node)) {}
+
+		std::shared_ptr<Internal::JobNode> m_Node;
+
+		friend class JobSystem;
+	};
+
+	//
+	// Work-stealing job scheduler
+	//
+	// Every worker owns a deque: it pushes and pops its own jobs at the back while idle workers
+	// steal from the front of the others, so there is no global queue to contend on.
+	// Jobs can depend on other jobs, and main-thread jobs are run by the Application
+	// main loop once their dependencies have finished.
+	//
+	class JobSystem
+	{
+	public:
+		using Job = std::function<void()>;
+	public:
+		// 0 workers = one per hardware thread, minus the main thread.
+		// The constructing thread is the main thread that runs ExecuteMainThreadJobs.
+		JobSystem(uint32_t workerCount = 0);
+		JobSystem(const JobSystem&) = delete;
+
+		// Runs all queued worker jobs before joining the workers
+		~JobSystem();
+
+		JobHandle Submit(Job job, std::initializer_list<JobHandle> dependencies = {});
+		JobHandle Submit(Job job, const std::vector<JobHandle>& dependencies);
+
+		// Runs on the main thread (see ExecuteMainThreadJobs) once all dependencies are finished
+		JobHandle SubmitMainThread(Job job, std::initializer_list<JobHandle> dependencies = {});
+		JobHandle SubmitMainThread(Job job, const std::vector<JobHandle>& dependencies);
+
+		// Calls func(index) for every index in [0, count) across all workers and the calling thread.
+		// Indices are handed out in batches of batchSize; returns once every index has been processed.
+		void ParallelFor(uint32_t count, uint32_t batchSize, const std::function<void(uint32_t)>& func);
+
+		// Blocks until the job has finished, running other jobs in the meantime
+		// (on the main thread, main-thread jobs too)
+		void Wait(const JobHandle& handle);
+		void Wait(const std::vector<JobHandle>& handles);
+
+		// Called by the Application main loop every frame
+		void ExecuteMainThreadJobs();
+
+		// Called from the scheduling thread whenever a main-thread job becomes ready,
+		// lets the main loop wake up instead of waiting out its sleep
+		void SetMainThreadWakeCallback(const std::function<void()>& callback) { m_MainThreadWakeCallback = callback; }
+
+		uint32_t GetWorkerCount() const { return (uint32_t)m_Workers.size(); }
+		bool IsWorkerThread() const;
+	private:
+		using JobPtr = std::shared_ptr<Internal::JobNode>;
+
+		JobHandle SubmitInternal(Job job, const JobHandle* dependencies, size_t dependencyCount, bool mainThread);
+		void Schedule(JobPtr job);
+		void Execute(const JobPtr& job);
+		bool TryRunOne();
+		JobPtr PopOrSteal(uint32_t workerIndex);
+
+		void WorkerThreadFunc(uint32_t workerIndex);
+	private:
+		struct Worker
+		{
+			std::thread Thread;
+			std::mutex QueueMutex;
+			std::deque<JobPtr> Queue;
+		};
+
+		std::vector<std::unique_ptr<Worker>> m_Workers;
+		std::atomic<bool> m_Running = true;
+
+		// Bumped on every push so sleeping workers wake (std::atomic wait/notify)
+		std::atomic<uint32_t> m_WorkSignal = 0;
+		std::atomic<uint32_t> m_NextQueue = 0;
+
+		std::mutex m_MainThreadQueueMutex;
+		std::vector<JobPtr> m_MainThreadQueue;
+		std::function<void()> m_MainThreadWakeCallback;
+		std::thread::id m_MainThreadID;
+	};
+
+}
@@ -3,6 +3,8 @@
 #include "spdlog/sinks/stdout_color_sinks.h"
 #include "spdlog/sinks/basic_file_sink.h"
 
+#include "RingBufferLogSink.h"
+
 #include <filesystem>
 
 #define WL_HAS_CONSOLE !WL_DIST
@@ -12,6 +14,8 @@ namespace Walnut {
 	std::shared_ptr<spdlog::logger> Log::s_CoreLogger;
 	std::shared_ptr<spdlog::logger> Log::s_ClientLogger;
 
+	static std::filesystem::path s_LogsDirectory;
+
 	std::filesystem::path GetLogsDirectory(const std::string& appName)
 	{
 		std::filesystem::path logsPath;
@@ -51,18 +55,30 @@ namespace Walnut {
 		return logsPath;
 	}
 
-	void Log::Init(const std::string& appName)
+	void Log::Init(const std::string& appName, uint64_t ringBufferSize)
 	{
 		// Create "logs" directory if doesn't exist
 		std::filesystem::path logsDirectory = GetLogsDirectory(appName);
+		s_LogsDirectory = logsDirectory;
 		if (!std::filesystem::exists(logsDirectory)) {
 			std::error_code ec;
 			std::filesystem::create_directories(logsDirectory, ec);
 		}
 
+		// Both loggers share one ring so the history reads back in order
+		std::shared_ptr<RingBufferLogSink_mt> ringSink;
+		if (ringBufferSize > 0)
+		{
+			ringSink = std::make_shared<RingBufferLogSink_mt>(logsDirectory / "WALNUT.ring", ringBufferSize);
+			if (ringSink->IsValid())
+				ringSink->set_pattern("[%Y-%m-%d %T.%e] [%l] [%t] %n: %v");
+			else
+				ringSink.reset();
+		}
+
 		std::vector<spdlog::sink_ptr> hazelSinks =
 		{
-			std::make_shared<spdlog::sinks::basic_file_sink_mt>(logsDirectory / "HAZEL.log", true),
+			ringSink ? spdlog::sink_ptr(ringSink) : std::make_shared<spdlog::sinks::basic_file_sink_mt>(logsDirectory / "HAZEL.log", true),
 #if WL_HAS_CONSOLE
 			std::make_shared<spdlog::sinks::stdout_color_sink_mt>()
 #endif
@@ -70,14 +86,17 @@ namespace Walnut {
 
 		std::vector<spdlog::sink_ptr> appSinks =
 		{
-			std::make_shared<spdlog::sinks::basic_file_sink_mt>(logsDirectory / "APP.log", true),
+			ringSink ? spdlog::sink_ptr(ringSink) : std::make_shared<spdlog::sinks::basic_file_sink_mt>(logsDirectory / "APP.log", true),
 #if WL_HAS_CONSOLE
 			std::make_shared<spdlog::sinks::stdout_color_sink_mt>()
 #endif
 		};
 
-		hazelSinks[0]->set_pattern("[%T] [%l] %n: %v");
-		appSinks[0]->set_pattern("[%T] [%l] %n: %v");
+		if (!ringSink)
+		{
+			hazelSinks[0]->set_pattern("[%T] [%l] %n: %v");
+			appSinks[0]->set_pattern("[%T] [%l] %n: %v");
+		}
 
 #if WL_HAS_CONSOLE
 		hazelSinks[1]->set_pattern("%^[%T] %n: %v%$");
@@ -93,9 +112,47 @@ namespace Walnut {
 
 	void Log::Shutdown()
 	{
+		ShutdownBinaryLog();
+
 		s_ClientLogger.reset();
 		s_CoreLogger.reset();
 		spdlog::drop_all();
 	}
 
+	void Log::AddSink(const spdlog::sink_ptr& sink)
+	{
+		for (auto& logger : { s_CoreLogger, s_ClientLogger })
+		{
+			if (logger)
+				logger->sinks().push_back(sink);
+		}
+	}
+
+	void Log::RemoveSink(const spdlog::sink_ptr& sink)
+	{
+		for (auto& logger : { s_CoreLogger, s_ClientLogger })
+		{
+			if (logger)
+				std::erase(logger->sinks(), sink);
+		}
+	}
+
+	void Log::InitBinaryLog(bool keepTextOutput)
+	{
+		s_BinaryLog = std::make_unique<BinaryLogWriter>(s_LogsDirectory / "WALNUT.wlog");
+		s_BinaryLogKeepText = keepTextOutput;
+
+		if (!s_BinaryLog->IsOpen())
+		{
+			s_BinaryLog.reset();
+			WL_CORE_ERROR_TAG("Log", "Failed to open binary log in {}", s_LogsDirectory.string());
+		}
+	}
+
+	void Log::ShutdownBinaryLog()
+	{
+		s_BinaryLog.reset();
+		s_BinaryLogKeepText = false;
+	}
+
 }
@@ -7,11 +7,13 @@
 // 
 
 #include "LogCustomFormatters.h"
+#include "BinaryLog.h"
 
 #include "spdlog/spdlog.h"
 #include "spdlog/fmt/ostr.h"
 
 #include <map>
+#include <shared_mutex>
 
 #define WL_ASSERT_MESSAGE_BOX (!WL_DIST && WL_PLATFORM_WINDOWS)
 
@@ -41,14 +43,37 @@ namespace Walnut {
 		};
 
 	public:
-		static void Init(const std::string& appName);
+		// With ringBufferSize > 0, the APP/HAZEL log files are replaced by a fixed-size,
+		// crash-safe memory-mapped ring at <logs>/WALNUT.ring (see MappedRingBuffer.h)
+		static void Init(const std::string& appName, uint64_t ringBufferSize = 0);
 		static void Shutdown();
 
+		// Writes all log calls to <logs>/WALNUT.wlog in binary form (see BinaryLog.h).
+		// Text sinks are skipped unless keepTextOutput is set.
+		static void InitBinaryLog(bool keepTextOutput = false);
+		static void ShutdownBinaryLog();
+		static BinaryLogWriter* GetBinaryLog() { return s_BinaryLog.get(); }
+
 		inline static std::shared_ptr<spdlog::logger>& GetCoreLogger() { return s_CoreLogger; }
 		inline static std::shared_ptr<spdlog::logger>& GetClientLogger() { return s_ClientLogger; }
 
-		static bool HasTag(const std::string& tag) { return s_EnabledTags.find(tag) != s_EnabledTags.end(); }
-		static std::map<std::string, TagDetails>& EnabledTags() { return s_EnabledTags; }
+		// Adds/removes a sink on both loggers. spdlog doesn't guard the sink list,
+		// so only call these while nothing else is logging (eg. during startup).
+		static void AddSink(const spdlog::sink_ptr& sink);
+		static void RemoveSink(const spdlog::sink_ptr& sink);
+
+		static bool HasTag(std::string_view tag)
+		{
+			std::shared_lock lock(s_EnabledTagsMutex);
+			return s_EnabledTags.find(tag) != s_EnabledTags.end();
+		}
+
+		// Thread-safe. Unknown tags are added with default details on first use.
+		static TagDetails GetTagDetails(std::string_view tag);
+		static void SetTagDetails(std::string_view tag, const TagDetails& details);
+
+		// Unsynchronized, only use while nothing else is logging (see AddSink)
+		static std::map<std::string, TagDetails, std::less<>>& EnabledTags() { return s_EnabledTags; }
 
 		template<typename... Args>
 		static void PrintMessageTag(Log::Type type, Log::Level level, std::string_view tag, std::format_string<Args...> format, Args&&... args);
@@ -87,54 +112,180 @@ namespace Walnut {
 		static std::shared_ptr<spdlog::logger> s_CoreLogger;
 		static std::shared_ptr<spdlog::logger> s_ClientLogger;
 
-		inline static std::map<std::string, TagDetails> s_EnabledTags;
+		// Looked up on every log call, a shared lock keeps that free of allocations and contention
+		inline static std::map<std::string, TagDetails, std::less<>> s_EnabledTags;
+		inline static std::shared_mutex s_EnabledTagsMutex;
+
+		inline static std::unique_ptr<BinaryLogWriter> s_BinaryLog;
+		inline static bool s_BinaryLogKeepText = false;
+	};
+
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Compile-time log level stripping                                                                                 //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// WL_LOG_MIN_LEVEL is the lowest level that gets compiled in. Macros below it expand to ((void)0),
+// so their arguments are never evaluated. Defaults to Info in Dist builds and Trace otherwise.
+//
+// Per-tag minimums can be set by defining WL_LOG_TAG_MIN_LEVELS before this header is included, eg.
+//   #define WL_LOG_TAG_MIN_LEVELS { "Network", ::Walnut::Log::Level::Warn }, { "Renderer", ::Walnut::Log::Level::Error }
+// Tagged calls below their tag's minimum are folded away by the compiler when the tag is a literal.
+//
+
+#define WL_LOG_LEVEL_TRACE 0
+#define WL_LOG_LEVEL_INFO  1
+#define WL_LOG_LEVEL_WARN  2
+#define WL_LOG_LEVEL_ERROR 3
+#define WL_LOG_LEVEL_FATAL 4
+#define WL_LOG_LEVEL_OFF   5
+
+#ifndef WL_LOG_MIN_LEVEL
+	#ifdef WL_DIST
+		#define WL_LOG_MIN_LEVEL WL_LOG_LEVEL_INFO
+	#else
+		#define WL_LOG_MIN_LEVEL WL_LOG_LEVEL_TRACE
+	#endif
+#endif
+
+#ifndef WL_LOG_TAG_MIN_LEVELS
+	#define WL_LOG_TAG_MIN_LEVELS
+#endif
+
+namespace Walnut::LogConfig {
+
+	struct TagMinLevel
+	{
+		std::string_view Tag;
+		Log::Level MinLevel = Log::Level::Trace;
 	};
 
+	// First entry is a sentinel so the array is never empty
+	inline constexpr TagMinLevel TagMinLevels[] = { { {}, Log::Level::Trace }, WL_LOG_TAG_MIN_LEVELS };
+
+	constexpr bool IsCompiledIn(std::string_view tag, Log::Level level)
+	{
+		if ((int)level < WL_LOG_MIN_LEVEL)
+			return false;
+
+		for (const TagMinLevel& entry : TagMinLevels)
+		{
+			if (!entry.Tag.empty() && entry.Tag == tag)
+				return level >= entry.MinLevel;
+		}
+
+		return true;
+	}
+
 }
 
+// The tag is bound once so expressions with side effects are only evaluated once
+#define WL_LOG_INTERNAL(type, level, tag, ...) [&](std::string_view wlLogTag) \
+	{ \
+		if (::Walnut::LogConfig::IsCompiledIn(wlLogTag, level)) \
+			::Walnut::Log::PrintMessageTag(type, level, wlLogTag, __VA_ARGS__); \
+	}(tag)
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Tagged logs (prefer these!)                                                                                      //
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-// Core logging
-#define WL_CORE_TRACE_TAG(tag, ...) ::Walnut::Log::PrintMessageTag(::Walnut::Log::Type::Core, ::Walnut::Log::Level::Trace, tag, __VA_ARGS__)
-#define WL_CORE_INFO_TAG(tag, ...)  ::Walnut::Log::PrintMessageTag(::Walnut::Log::Type::Core, ::Walnut::Log::Level::Info, tag, __VA_ARGS__)
-#define WL_CORE_WARN_TAG(tag, ...)  ::Walnut::Log::PrintMessageTag(::Walnut::Log::Type::Core, ::Walnut::Log::Level::Warn, tag, __VA_ARGS__)
-#define WL_CORE_ERROR_TAG(tag, ...) ::Walnut::Log::PrintMessageTag(::Walnut::Log::Type::Core, ::Walnut::Log::Level::Error, tag, __VA_ARGS__)
-#define WL_CORE_FATAL_TAG(tag, ...) ::Walnut::Log::PrintMessageTag(::Walnut::Log::Type::Core, ::Walnut::Log::Level::Fatal, tag, __VA_ARGS__)
+#if WL_LOG_MIN_LEVEL <= WL_LOG_LEVEL_TRACE
+	#define WL_CORE_TRACE_TAG(tag, ...) WL_LOG_INTERNAL(::Walnut::Log::Type::Core, ::Walnut::Log::Level::Trace, tag, __VA_ARGS__)
+	#define WL_TRACE_TAG(tag, ...)      WL_LOG_INTERNAL(::Walnut::Log::Type::Client, ::Walnut::Log::Level::Trace, tag, __VA_ARGS__)
+#else
+	#define WL_CORE_TRACE_TAG(tag, ...) ((void)0)
+	#define WL_TRACE_TAG(tag, ...)      ((void)0)
+#endif
+
+#if WL_LOG_MIN_LEVEL <= WL_LOG_LEVEL_INFO
+	#define WL_CORE_INFO_TAG(tag, ...)  WL_LOG_INTERNAL(::Walnut::Log::Type::Core, ::Walnut::Log::Level::Info, tag, __VA_ARGS__)
+	#define WL_INFO_TAG(tag, ...)       WL_LOG_INTERNAL(::Walnut::Log::Type::Client, ::Walnut::Log::Level::Info, tag, __VA_ARGS__)
+#else
+	#define WL_CORE_INFO_TAG(tag, ...)  ((void)0)
+	#define WL_INFO_TAG(tag, ...)       ((void)0)
+#endif
+
+#if WL_LOG_MIN_LEVEL <= WL_LOG_LEVEL_WARN
+	#define WL_CORE_WARN_TAG(tag, ...)  WL_LOG_INTERNAL(::Walnut::Log::Type::Core, ::Walnut::Log::Level::Warn, tag, __VA_ARGS__)
+	#define WL_WARN_TAG(tag, ...)       WL_LOG_INTERNAL(::Walnut::Log::Type::Client, ::Walnut::Log::Level::Warn, tag, __VA_ARGS__)
+#else
+	#define WL_CORE_WARN_TAG(tag, ...)  ((void)0)
+	#define WL_WARN_TAG(tag, ...)       ((void)0)
+#endif
 
-// Client logging
-#define WL_TRACE_TAG(tag, ...) ::Walnut::Log::PrintMessageTag(::Walnut::Log::Type::Client, ::Walnut::Log::Level::Trace, tag, __VA_ARGS__)
-#define WL_INFO_TAG(tag, ...)  ::Walnut::Log::PrintMessageTag(::Walnut::Log::Type::Client, ::Walnut::Log::Level::Info, tag, __VA_ARGS__)
-#define WL_WARN_TAG(tag, ...)  ::Walnut::Log::PrintMessageTag(::Walnut::Log::Type::Client, ::Walnut::Log::Level::Warn, tag, __VA_ARGS__)
-#define WL_ERROR_TAG(tag, ...) ::Walnut::Log::PrintMessageTag(::Walnut::Log::Type::Client, ::Walnut::Log::Level::Error, tag, __VA_ARGS__)
-#define WL_FATAL_TAG(tag, ...) ::Walnut::Log::PrintMessageTag(::Walnut::Log::Type::Client, ::Walnut::Log::Level::Fatal, tag, __VA_ARGS__)
+#if WL_LOG_MIN_LEVEL <= WL_LOG_LEVEL_ERROR
+	#define WL_CORE_ERROR_TAG(tag, ...) WL_LOG_INTERNAL(::Walnut::Log::Type::Core, ::Walnut::Log::Level::Error, tag, __VA_ARGS__)
+	#define WL_ERROR_TAG(tag, ...)      WL_LOG_INTERNAL(::Walnut::Log::Type::Client, ::Walnut::Log::Level::Error, tag, __VA_ARGS__)
+#else
+	#define WL_CORE_ERROR_TAG(tag, ...) ((void)0)
+	#define WL_ERROR_TAG(tag, ...)      ((void)0)
+#endif
+
+#if WL_LOG_MIN_LEVEL <= WL_LOG_LEVEL_FATAL
+	#define WL_CORE_FATAL_TAG(tag, ...) WL_LOG_INTERNAL(::Walnut::Log::Type::Core, ::Walnut::Log::Level::Fatal, tag, __VA_ARGS__)
+	#define WL_FATAL_TAG(tag, ...)      WL_LOG_INTERNAL(::Walnut::Log::Type::Client, ::Walnut::Log::Level::Fatal, tag, __VA_ARGS__)
+#else
+	#define WL_CORE_FATAL_TAG(tag, ...) ((void)0)
+	#define WL_FATAL_TAG(tag, ...)      ((void)0)
+#endif
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 // Core Logging
-#define WL_CORE_TRACE(...)  ::Walnut::Log::PrintMessageTag(::Walnut::Log::Type::Core, ::Walnut::Log::Level::Trace, "CORE", __VA_ARGS__)
-#define WL_CORE_INFO(...)   ::Walnut::Log::PrintMessageTag(::Walnut::Log::Type::Core, ::Walnut::Log::Level::Info, "CORE", __VA_ARGS__)
-#define WL_CORE_WARN(...)   ::Walnut::Log::PrintMessageTag(::Walnut::Log::Type::Core, ::Walnut::Log::Level::Warn, "CORE", __VA_ARGS__)
-#define WL_CORE_ERROR(...)  ::Walnut::Log::PrintMessageTag(::Walnut::Log::Type::Core, ::Walnut::Log::Level::Error, "CORE", __VA_ARGS__)
-#define WL_CORE_FATAL(...)  ::Walnut::Log::PrintMessageTag(::Walnut::Log::Type::Core, ::Walnut::Log::Level::Fatal, "CORE", __VA_ARGS__)
+#define WL_CORE_TRACE(...)  WL_CORE_TRACE_TAG("CORE", __VA_ARGS__)
+#define WL_CORE_INFO(...)   WL_CORE_INFO_TAG("CORE", __VA_ARGS__)
+#define WL_CORE_WARN(...)   WL_CORE_WARN_TAG("CORE", __VA_ARGS__)
+#define WL_CORE_ERROR(...)  WL_CORE_ERROR_TAG("CORE", __VA_ARGS__)
+#define WL_CORE_FATAL(...)  WL_CORE_FATAL_TAG("CORE", __VA_ARGS__)
 
 // Client Logging
-#define WL_TRACE(...)   ::Walnut::Log::PrintMessageTag(::Walnut::Log::Type::Client, ::Walnut::Log::Level::Trace, "CLIENT", __VA_ARGS__)
-#define WL_INFO(...)    ::Walnut::Log::PrintMessageTag(::Walnut::Log::Type::Client, ::Walnut::Log::Level::Info, "CLIENT", __VA_ARGS__)
-#define WL_WARN(...)    ::Walnut::Log::PrintMessageTag(::Walnut::Log::Type::Client, ::Walnut::Log::Level::Warn, "CLIENT", __VA_ARGS__)
-#define WL_ERROR(...)   ::Walnut::Log::PrintMessageTag(::Walnut::Log::Type::Client, ::Walnut::Log::Level::Error, "CLIENT", __VA_ARGS__)
-#define WL_FATAL(...)   ::Walnut::Log::PrintMessageTag(::Walnut::Log::Type::Client, ::Walnut::Log::Level::Fatal, "CLIENT", __VA_ARGS__)
+#define WL_TRACE(...)   WL_TRACE_TAG("CLIENT", __VA_ARGS__)
+#define WL_INFO(...)    WL_INFO_TAG("CLIENT", __VA_ARGS__)
+#define WL_WARN(...)    WL_WARN_TAG("CLIENT", __VA_ARGS__)
+#define WL_ERROR(...)   WL_ERROR_TAG("CLIENT", __VA_ARGS__)
+#define WL_FATAL(...)   WL_FATAL_TAG("CLIENT", __VA_ARGS__)
 
 namespace Walnut {
 
 
+	inline Log::TagDetails Log::GetTagDetails(std::string_view tag)
+	{
+		{
+			std::shared_lock lock(s_EnabledTagsMutex);
+			auto it = s_EnabledTags.find(tag);
+			if (it != s_EnabledTags.end())
+				return it->second;
+		}
+
+		std::unique_lock lock(s_EnabledTagsMutex);
+		return s_EnabledTags.try_emplace(std::string(tag)).first->second;
+	}
+
+	inline void Log::SetTagDetails(std::string_view tag, const TagDetails& details)
+	{
+		std::unique_lock lock(s_EnabledTagsMutex);
+		auto it = s_EnabledTags.find(tag);
+		if (it != s_EnabledTags.end())
+			it->second = details;
+		else
+			s_EnabledTags.emplace(std::string(tag), details);
+	}
+
 	template<typename... Args>
 	void Log::PrintMessageTag(Log::Type type, Log::Level level, std::string_view tag, const std::format_string<Args...> format, Args&&... args)
 	{
-		auto detail = s_EnabledTags[std::string(tag)];
+		const TagDetails detail = GetTagDetails(tag);
 		if (detail.Enabled && detail.LevelFilter <= level)
 		{
+			if (s_BinaryLog)
+			{
+				s_BinaryLog->Write((uint8_t)type, (uint8_t)level, tag, format.get(), args...);
+				if (!s_BinaryLogKeepText)
+					return;
+			}
+
 			auto logger = (type == Type::Core) ? GetCoreLogger() : GetClientLogger();
 			std::string formatted = std::format(format, std::forward<Args>(args)...);
 			switch (level)
@@ -161,9 +312,16 @@ namespace Walnut {
 
 	inline void Log::PrintMessageTag(Log::Type type, Log::Level level, std::string_view tag, std::string_view message)
 	{
-		auto detail = s_EnabledTags[std::string(tag)];
+		const TagDetails detail = GetTagDetails(tag);
 		if (detail.Enabled && detail.LevelFilter <= level)
 		{
+			if (s_BinaryLog)
+			{
+				s_BinaryLog->Write((uint8_t)type, (uint8_t)level, tag, "{}", message);
+				if (!s_BinaryLogKeepText)
+					return;
+			}
+
 			auto logger = (type == Type::Core) ? GetCoreLogger() : GetClientLogger();
 			switch (level)
 			{
@@ -0,0 +1,226 @@
+#include "MappedRingBuffer.h"
+
+#include <atomic>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+#ifdef _WIN32
+	#include <Windows.h>
+#else
+	#include <fcntl.h>
+	#include <unistd.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+#endif
+
+namespace Walnut {
+
+	static constexpr char s_RingBufferMagic[4] = { 'W', 'L', 'R', 'B' };
+	static constexpr uint32_t s_RingBufferVersion = 1;
+
+	MappedRingBuffer::MappedRingBuffer(const std::filesystem::path& filepath, uint64_t capacity)
+		: m_Capacity(capacity)
+	{
+		// Must hold at least a record size and one byte, the buffer stays invalid otherwise
+		if (capacity <= sizeof(uint32_t))
+			return;
+
+		m_MappedSize = sizeof(Header) + capacity;
+
+#ifdef _WIN32
+		HANDLE file = CreateFileW(filepath.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+			return;
+
+		HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READWRITE, (DWORD)(m_MappedSize >> 32), (DWORD)(m_MappedSize & 0xffffffff), nullptr);
+		if (!mapping)
+		{
+			CloseHandle(file);
+			return;
+		}
+
+		void* memory = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, m_MappedSize);
+		if (!memory)
+		{
+			CloseHandle(mapping);
+			CloseHandle(file);
+			return;
+		}
+
+		m_FileHandle = file;
+		m_MappingHandle = mapping;
+#else
+		int fd = open(filepath.c_str(), O_RDWR | O_CREAT, 0644);
+		if (fd < 0)
+			return;
+
+		struct stat info;
+		if (fstat(fd, &info) != 0 || ((uint64_t)info.st_size != m_MappedSize && ftruncate(fd, (off_t)m_MappedSize) != 0))
+		{
+			close(fd);
+			return;
+		}
+
+		void* memory = mmap(nullptr, m_MappedSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		if (memory == MAP_FAILED)
+		{
+			close(fd);
+			return;
+		}
+
+		m_FileDescriptor = fd;
+#endif
+
+		m_Header = (Header*)memory;
+		m_Data = (uint8_t*)memory + sizeof(Header);
+
+		// Keep the history of a previous run if the file is compatible, otherwise start over
+		const bool compatible = memcmp(m_Header->Magic, s_RingBufferMagic, sizeof(s_RingBufferMagic)) == 0
+			&& m_Header->Version == s_RingBufferVersion
+			&& m_Header->Capacity == capacity
+			&& m_Header->Tail <= m_Header->Head
+			&& m_Header->Head - m_Header->Tail <= capacity;
+
+		if (!compatible)
+		{
+			memcpy(m_Header->Magic, s_RingBufferMagic, sizeof(s_RingBufferMagic));
+			m_Header->Version = s_RingBufferVersion;
+			m_Header->Capacity = capacity;
+			m_Header->Head = 0;
+			m_Header->Tail = 0;
+		}
+	}
+
+	MappedRingBuffer::~MappedRingBuffer()
+	{
+		if (!m_Header)
+			return;
+
+#ifdef _WIN32
+		FlushViewOfFile(m_Header, 0);
+		UnmapViewOfFile(m_Header);
+		CloseHandle((HANDLE)m_MappingHandle);
+		CloseHandle((HANDLE)m_FileHandle);
+#else
+		msync(m_Header, m_MappedSize, MS_ASYNC);
+		munmap(m_Header, m_MappedSize);
+		close(m_FileDescriptor);
+#endif
+
+		m_Header = nullptr;
+		m_Data = nullptr;
+	}
+
+	void MappedRingBuffer::Write(const void* data, uint32_t size)
+	{
+		if (!m_Header)
+			return;
+
+		// Oversized records are truncated to fit
+		size = (uint32_t)std::min<uint64_t>(size, m_Capacity - sizeof(uint32_t));
+		const uint64_t recordSize = sizeof(uint32_t) + size;
+
+		std::atomic_ref<uint64_t> headRef(m_Header->Head);
+		std::atomic_ref<uint64_t> tailRef(m_Header->Tail);
+
+		const uint64_t head = headRef.load(std::memory_order_relaxed);
+		uint64_t tail = tailRef.load(std::memory_order_relaxed);
+
+		// Drop the oldest records until the new one fits
+		while (head + recordSize - tail > m_Capacity)
+		{
+			uint32_t oldSize;
+			CopyOut(tail, &oldSize, sizeof(uint32_t));
+			tail += sizeof(uint32_t) + oldSize;
+		}
+		tailRef.store(tail, std::memory_order_release);
+
+		CopyIn(head, &size, sizeof(uint32_t));
+		CopyIn(head + sizeof(uint32_t), data, size);
+
+		headRef.store(head + recordSize, std::memory_order_release);
+	}
+
+	void MappedRingBuffer::Flush()
+	{
+		if (!m_Header)
+			return;
+
+#ifdef _WIN32
+		FlushViewOfFile(m_Header, 0);
+#else
+		msync(m_Header, m_MappedSize, MS_ASYNC);
+#endif
+	}
+
+	void MappedRingBuffer::CopyIn(uint64_t position, const void* data, uint64_t size)
+	{
+		const uint64_t offset = position % m_Capacity;
+		const uint64_t first = std::min(size, m_Capacity - offset);
+		memcpy(m_Data + offset, data, first);
+		memcpy(m_Data, (const uint8_t*)data + first, size - first);
+	}
+
+	void MappedRingBuffer::CopyOut(uint64_t position, void* data, uint64_t size) const
+	{
+		const uint64_t offset = position % m_Capacity;
+		const uint64_t first = std::min(size, m_Capacity - offset);
+		memcpy(data, m_Data + offset, first);
+		memcpy((uint8_t*)data + first, m_Data, size - first);
+	}
+
+	std::vector<std::string> MappedRingBuffer::ReadRecords(const std::filesystem::path& filepath)
+	{
+		std::vector<std::string> records;
+
+		std::ifstream stream(filepath, std::ifstream::in | std::ifstream::binary);
+		Header header;
+		stream.read((char*)&header, sizeof(Header));
+		if ((size_t)stream.gcount() != sizeof(Header) || memcmp(header.Magic, s_RingBufferMagic, sizeof(s_RingBufferMagic)) != 0)
+			return records;
+
+		if (header.Version != s_RingBufferVersion || header.Capacity <= sizeof(uint32_t) || header.Tail > header.Head || header.Head - header.Tail > header.Capacity)
+			return records;
+
+		std::vector<uint8_t> data(header.Capacity);
+		stream.read((char*)data.data(), header.Capacity);
+		if ((uint64_t)stream.gcount() != header.Capacity)
+			return records;
+
+		auto copyOut = [&](uint64_t position, void* out, uint64_t size)
+		{
+			const uint64_t offset = position % header.Capacity;
+			const uint64_t first = std::min(size, header.Capacity - offset);
+			memcpy(out, data.data() + offset, first);
+			memcpy((uint8_t*)out + first, data.data(), size - first);
+		};
+
+		uint64_t position = header.Tail;
+		while (header.Head - position >= sizeof(uint32_t))
+		{
+			uint32_t size;
+			copyOut(position, &size, sizeof(uint32_t));
+			position += sizeof(uint32_t);
+
+			// Corrupt size, stop rather than read garbage
+			if (size > header.Head - position)
+				break;
+
+			std::string& record = records.emplace_back(size, '\0');
+			copyOut(position, record.data(), size);
+			position += size;
+		}
+
+		return records;
+	}
+
+	bool MappedRingBuffer::IsRingBufferFile(const std::filesystem::path& filepath)
+	{
+		std::ifstream stream(filepath, std::ifstream::in | std::ifstream::binary);
+		char magic[4];
+		stream.read(magic, sizeof(magic));
+		return stream.gcount() == sizeof(magic) && memcmp(magic, s_RingBufferMagic, sizeof(magic)) == 0;
+	}
+
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+//
+// Fixed-size, memory-mapped circular record buffer
+//
+// The file is mapped shared, so everything written survives a process crash (the kernel owns the pages)
+// without an fsync per record. Once full, the oldest records are dropped to make room for new ones.
+//
+// File layout (little-endian):
+//   Header:  "WLRB" | u32 version | u64 capacity | u64 head | u64 tail
+//   Data:    capacity bytes, records are u32 size | bytes and wrap around the end
+//
+// Head and tail are monotonic byte counts; the live records are [tail, head). The tail is advanced
+// before old data is overwritten and the head only after a record is complete, so a crash mid-write
+// never exposes a torn record.
+//
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <filesystem>
+
+namespace Walnut {
+
+	class MappedRingBuffer
+	{
+	public:
+		// Capacity must be larger than sizeof(uint32_t), IsValid() returns false otherwise
+		MappedRingBuffer(const std::filesystem::path& filepath, uint64_t capacity);
+		MappedRingBuffer(const MappedRingBuffer&) = delete;
+		~MappedRingBuffer();
+
+		bool IsValid() const { return m_Header != nullptr; }
+		uint64_t GetCapacity() const { return m_Capacity; }
+
+		// Not thread-safe, callers serialize writes
+		void Write(const void* data, uint32_t size);
+		void Write(std::string_view string) { Write(string.data(), (uint32_t)string.size()); }
+
+		// Schedules write-back to disk without blocking
+		void Flush();
+
+		// Reconstructs the live records of a ring buffer file, oldest first
+		static std::vector<std::string> ReadRecords(const std::filesystem::path& filepath);
+		static bool IsRingBufferFile(const std::filesystem::path& filepath);
+	private:
+		void CopyIn(uint64_t position, const void* data, uint64_t size);
+		void CopyOut(uint64_t position, void* data, uint64_t size) const;
+	private:
+		struct Header
+		{
+			char Magic[4];
+			uint32_t Version;
+			uint64_t Capacity;
+			uint64_t Head;
+			uint64_t Tail;
+		};
+
+		Header* m_Header = nullptr;
+		uint8_t* m_Data = nullptr;
+		uint64_t m_Capacity = 0;
+		uint64_t m_MappedSize = 0;
+
+#ifdef _WIN32
+		void* m_FileHandle = nullptr;
+		void* m_MappingHandle = nullptr;
+#else
+		int m_FileDescriptor = -1;
+#endif
+	};
+
+}
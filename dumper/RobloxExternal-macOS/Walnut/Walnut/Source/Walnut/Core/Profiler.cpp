@@ -0,0 +1,335 @@
+#include "Profiler.h"
+
+#include "Walnut/Timer.h"
+
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <typeindex>
+
+#if defined(__GNUC__) || defined(__clang__)
+	#include <cxxabi.h>
+	#include <cstdlib>
+#endif
+
+namespace Walnut {
+
+	namespace {
+
+		struct ThreadBuffer
+		{
+			// Fields are relaxed atomics so Capture() may read while the owner writes,
+			// torn slots are detected with Head and dropped
+			struct Slot
+			{
+				std::atomic<const char*> Name;
+				std::atomic<uint64_t> Start;
+				std::atomic<uint64_t> End;
+				std::atomic<uint32_t> Depth;
+			};
+
+			std::string Name;
+			uint32_t ThreadIndex = 0;
+
+			std::unique_ptr<Slot[]> Slots = std::make_unique<Slot[]>(Profiler::ThreadBufferCapacity);
+
+			// Total zones ever written, only the owning thread stores to it
+			std::atomic<uint64_t> Head = 0;
+		};
+
+		struct ProfilerRegistry
+		{
+			std::mutex Mutex;
+			std::vector<std::shared_ptr<ThreadBuffer>> ThreadBuffers;
+			uint32_t NextThreadIndex = 0;
+
+			std::mutex InternMutex;
+			std::unordered_set<std::string> InternedStrings;
+			std::unordered_map<std::type_index, const char*> TypeNames;
+
+			std::atomic<uint64_t> FrameStarts[Profiler::FrameHistoryCapacity] = {};
+			std::atomic<uint64_t> FrameCount = 0;
+
+			const int64_t Epoch = Clock::Now();
+		};
+
+		ProfilerRegistry& GetRegistry()
+		{
+			static ProfilerRegistry registry;
+			return registry;
+		}
+
+		// Unregisters the buffer when its thread exits, so thread churn doesn't grow the registry
+		struct ThreadBufferHandle
+		{
+			std::shared_ptr<ThreadBuffer> Buffer;
+
+			~ThreadBufferHandle()
+			{
+				if (!Buffer)
+					return;
+
+				ProfilerRegistry& registry = GetRegistry();
+				std::scoped_lock<std::mutex> lock(registry.Mutex);
+				std::erase(registry.ThreadBuffers, Buffer);
+			}
+		};
+
+		thread_local ThreadBufferHandle s_ThreadBuffer;
+
+		ThreadBuffer& GetThreadBuffer()
+		{
+			if (!s_ThreadBuffer.Buffer)
+			{
+				auto buffer = std::make_shared<ThreadBuffer>();
+
+				ProfilerRegistry& registry = GetRegistry();
+				std::scoped_lock<std::mutex> lock(registry.Mutex);
+				buffer->ThreadIndex = registry.NextThreadIndex++;
+				buffer->Name = "Thread " + std::to_string(buffer->ThreadIndex);
+				registry.ThreadBuffers.push_back(buffer);
+
+				s_ThreadBuffer.Buffer = std::move(buffer);
+			}
+
+			return *s_ThreadBuffer.Buffer;
+		}
+
+		void WriteJSONString(std::ostream& stream, std::string_view str)
+		{
+			stream << '"';
+			for (char c : str)
+			{
+				switch (c)
+				{
+					case '"':  stream << "\\\""; break;
+					case '\\': stream << "\\\\"; break;
+					case '\n': stream << "\\n"; break;
+					case '\t': stream << "\\t"; break;
+					default:
+						if ((unsigned char)c < 0x20)
+							stream << "\\u" << std::hex << std::setw(4) << std::setfill('0') << (int)c << std::dec << std::setfill(' ');
+						else
+							stream << c;
+				}
+			}
+			stream << '"';
+		}
+
+	}
+
+	void Profiler::SetThreadName(std::string_view name)
+	{
+		ThreadBuffer& buffer = GetThreadBuffer();
+
+		std::scoped_lock<std::mutex> lock(GetRegistry().Mutex);
+		buffer.Name = name;
+	}
+
+	void Profiler::MarkFrame()
+	{
+		ProfilerRegistry& registry = GetRegistry();
+		const uint64_t frame = registry.FrameCount.load(std::memory_order_relaxed);
+		registry.FrameStarts[frame % FrameHistoryCapacity].store(GetTime(), std::memory_order_relaxed);
+		registry.FrameCount.store(frame + 1, std::memory_order_release);
+	}
+
+	uint64_t Profiler::GetTime()
+	{
+		return (uint64_t)(Clock::Now() - GetRegistry().Epoch);
+	}
+
+	void Profiler::RecordZone(const char* name, uint64_t start, uint64_t end, uint32_t depth)
+	{
+		ThreadBuffer& buffer = GetThreadBuffer();
+
+		const uint64_t index = buffer.Head.load(std::memory_order_relaxed);
+
+		// Pairs with the acquire fence in Capture(): a reader that sees any of the stores
+		// below is guaranteed to also see Head >= index and drop this slot
+		std::atomic_thread_fence(std::memory_order_release);
+
+		ThreadBuffer::Slot& slot = buffer.Slots[index % ThreadBufferCapacity];
+		slot.Name.store(name, std::memory_order_relaxed);
+		slot.Start.store(start, std::memory_order_relaxed);
+		slot.End.store(end, std::memory_order_relaxed);
+		slot.Depth.store(depth, std::memory_order_relaxed);
+
+		buffer.Head.store(index + 1, std::memory_order_release);
+	}
+
+	ProfileCapture Profiler::Capture()
+	{
+		ProfilerRegistry& registry = GetRegistry();
+
+		ProfileCapture capture;
+		std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+		{
+			std::scoped_lock<std::mutex> lock(registry.Mutex);
+			buffers = registry.ThreadBuffers;
+
+			capture.Threads.reserve(buffers.size());
+			for (const auto& buffer : buffers)
+			{
+				ProfileThreadCapture& thread = capture.Threads.emplace_back();
+				thread.Name = buffer->Name;
+				thread.ThreadIndex = buffer->ThreadIndex;
+			}
+		}
+
+		for (size_t i = 0; i < buffers.size(); i++)
+		{
+			ThreadBuffer& buffer = *buffers[i];
+			std::vector<ProfileZone>& zones = capture.Threads[i].Zones;
+
+			const uint64_t head = buffer.Head.load(std::memory_order_acquire);
+			const uint64_t first = head > ThreadBufferCapacity ? head - ThreadBufferCapacity : 0;
+
+			zones.resize(head - first);
+			for (uint64_t index = first; index < head; index++)
+			{
+				const ThreadBuffer::Slot& slot = buffer.Slots[index % ThreadBufferCapacity];
+				ProfileZone& zone = zones[index - first];
+				zone.Name = slot.Name.load(std::memory_order_relaxed);
+				zone.Start = slot.Start.load(std::memory_order_relaxed);
+				zone.End = slot.End.load(std::memory_order_relaxed);
+				zone.Depth = slot.Depth.load(std::memory_order_relaxed);
+			}
+
+			// The writer may have lapped us while copying, drop every slot it could have touched
+			std::atomic_thread_fence(std::memory_order_acquire);
+			const uint64_t headAfter = buffer.Head.load(std::memory_order_relaxed);
+			const uint64_t firstValid = headAfter >= ThreadBufferCapacity ? headAfter - ThreadBufferCapacity + 1 : 0;
+			if (firstValid > first)
+				zones.erase(zones.begin(), zones.begin() + (ptrdiff_t)std::min(firstValid - first, (uint64_t)zones.size()));
+		}
+
+		const uint64_t frameCount = registry.FrameCount.load(std::memory_order_acquire);
+		const uint64_t firstFrame = frameCount > FrameHistoryCapacity ? frameCount - FrameHistoryCapacity : 0;
+		capture.FrameStarts.reserve(frameCount - firstFrame);
+		for (uint64_t frame = firstFrame; frame < frameCount; frame++)
+			capture.FrameStarts.push_back(registry.FrameStarts[frame % FrameHistoryCapacity].load(std::memory_order_relaxed));
+
+		return capture;
+	}
+
+	bool Profiler::ExportChromeTrace(const std::filesystem::path& filepath)
+	{
+		return ExportChromeTrace(Capture(), filepath);
+	}
+
+	bool Profiler::ExportChromeTrace(const ProfileCapture& capture, const std::filesystem::path& filepath)
+	{
+		std::ofstream stream(filepath);
+		if (!stream)
+			return false;
+
+		// Timestamps are in microseconds
+		stream << std::fixed << std::setprecision(3);
+		stream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+		bool first = true;
+		auto separator = [&]()
+		{
+			if (!first)
+				stream << ",";
+			stream << "\n";
+			first = false;
+		};
+
+		for (const ProfileThreadCapture& thread : capture.Threads)
+		{
+			separator();
+			stream << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << thread.ThreadIndex << ",\"args\":{\"name\":";
+			WriteJSONString(stream, thread.Name);
+			stream << "}}";
+
+			for (const ProfileZone& zone : thread.Zones)
+			{
+				separator();
+				stream << "{\"name\":";
+				WriteJSONString(stream, zone.Name ? zone.Name : "");
+				stream << ",\"cat\":\"zone\",\"ph\":\"X\",\"pid\":0,\"tid\":" << thread.ThreadIndex
+					<< ",\"ts\":" << zone.Start * 0.001 << ",\"dur\":" << (zone.End - zone.Start) * 0.001 << "}";
+			}
+		}
+
+		for (uint64_t frameStart : capture.FrameStarts)
+		{
+			separator();
+			stream << "{\"name\":\"Frame\",\"ph\":\"i\",\"s\":\"g\",\"pid\":0,\"tid\":0,\"ts\":" << frameStart * 0.001 << "}";
+		}
+
+		stream << "\n]}\n";
+		return (bool)stream;
+	}
+
+	const char* Profiler::InternString(std::string_view str)
+	{
+		ProfilerRegistry& registry = GetRegistry();
+		std::scoped_lock<std::mutex> lock(registry.InternMutex);
+
+		// Elements of a node-based set never move
+		return registry.InternedStrings.emplace(str).first->c_str();
+	}
+
+	const char* Profiler::GetTypeName(const std::type_info& type)
+	{
+		ProfilerRegistry& registry = GetRegistry();
+		{
+			std::scoped_lock<std::mutex> lock(registry.InternMutex);
+			auto it = registry.TypeNames.find(type);
+			if (it != registry.TypeNames.end())
+				return it->second;
+		}
+
+		std::string name = type.name();
+#if defined(__GNUC__) || defined(__clang__)
+		int status = 0;
+		char* demangled = abi::__cxa_demangle(type.name(), nullptr, nullptr, &status);
+		if (status == 0 && demangled)
+			name = demangled;
+		std::free(demangled);
+#else
+		for (std::string_view prefix : { "class ", "struct " })
+		{
+			if (name.starts_with(prefix))
+				name.erase(0, prefix.size());
+		}
+#endif
+
+		const char* interned = InternString(name);
+
+		std::scoped_lock<std::mutex> lock(registry.InternMutex);
+		registry.TypeNames.emplace(type, interned);
+		return interned;
+	}
+
+	const char* Profiler::GetMemberZoneName(const std::type_info& type, const char* member)
+	{
+		struct MemberZoneName
+		{
+			const char* Member;
+			const char* Name;
+		};
+
+		// Types have only a few profiled members, a linear search is enough
+		static thread_local std::unordered_map<std::type_index, std::vector<MemberZoneName>> s_ZoneNames;
+
+		std::vector<MemberZoneName>& names = s_ZoneNames[type];
+		for (const MemberZoneName& entry : names)
+		{
+			if (entry.Member == member || strcmp(entry.Member, member) == 0)
+				return entry.Name;
+		}
+
+		const char* name = InternString(std::string(GetTypeName(type)) + "::" + member);
+		names.push_back({ InternString(member), name });
+		return name;
+	}
+
+}
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <typeinfo>
+#include <vector>
+
+// Profiling stays compiled into every configuration (including Dist) so frame spikes
+// can be tracked down in production; define as 0 to strip all zones
+#ifndef WL_ENABLE_PROFILING
+	#define WL_ENABLE_PROFILING 1
+#endif
+
+namespace Walnut {
+
+	struct ProfileZone
+	{
+		// Must outlive the profiler: string literals, or Profiler::InternString
+		const char* Name = nullptr;
+
+		// Nanoseconds since the profiler started
+		uint64_t Start = 0;
+		uint64_t End = 0;
+
+		// Nesting level on its thread, 0 = outermost
+		uint32_t Depth = 0;
+	};
+
+	struct ProfileThreadCapture
+	{
+		std::string Name;
+		uint32_t ThreadIndex = 0;
+
+		// In completion order
+		std::vector<ProfileZone> Zones;
+	};
+
+	struct ProfileCapture
+	{
+		std::vector<ProfileThreadCapture> Threads;
+
+		// Start time of the most recent frames, oldest first
+		std::vector<uint64_t> FrameStarts;
+	};
+
+	//
+	// Built-in instrumentation profiler
+	//
+	// Every thread records completed zones into its own fixed-size ring buffer, so recording
+	// is a couple of clock reads and plain stores with no locks or allocations. Capture() copies
+	// the buffers out at any time from any thread; the oldest zones are overwritten.
+	//
+	class Profiler
+	{
+	public:
+		static constexpr uint32_t ThreadBufferCapacity = 8192;
+		static constexpr uint32_t FrameHistoryCapacity = 512;
+	public:
+		static void SetEnabled(bool enabled) { s_Enabled.store(enabled, std::memory_order_relaxed); }
+		static bool IsEnabled() { return s_Enabled.load(std::memory_order_relaxed); }
+
+		// Shown in the timeline and trace export, defaults to "Thread <index>"
+		static void SetThreadName(std::string_view name);
+
+		// Called by the Application main loop at the start of every frame
+		static void MarkFrame();
+
+		static uint64_t GetTime();
+
+		static void RecordZone(const char* name, uint64_t start, uint64_t end, uint32_t depth);
+
+		static ProfileCapture Capture();
+
+		// Chrome trace event format, open with chrome://tracing, Perfetto or Speedscope
+		static bool ExportChromeTrace(const std::filesystem::path& filepath);
+		static bool ExportChromeTrace(const ProfileCapture& capture, const std::filesystem::path& filepath);
+
+		// Returns a copy of str that stays valid for the rest of the program, for dynamic zone names
+		static const char* InternString(std::string_view str);
+
+		// Readable (demangled) type name, interned
+		static const char* GetTypeName(const std::type_info& type);
+
+		// "<type name>::<member>", interned. Cached per thread, so cheap enough to call every frame
+		// (eg. WL_PROFILE_SCOPE(Profiler::GetMemberZoneName(typeid(*layer), "OnUpdate")))
+		static const char* GetMemberZoneName(const std::type_info& type, const char* member);
+	private:
+		inline static std::atomic<bool> s_Enabled = true;
+		inline static thread_local uint32_t s_Depth = 0;
+
+		friend class ProfileScope;
+	};
+
+	class ProfileScope
+	{
+	public:
+		ProfileScope(const char* name)
+		{
+			if (!Profiler::IsEnabled())
+				return;
+
+			m_Name = name;
+			m_Depth = Profiler::s_Depth++;
+			m_Start = Profiler::GetTime();
+		}
+
+		~ProfileScope()
+		{
+			if (!m_Name)
+				return;
+
+			Profiler::RecordZone(m_Name, m_Start, Profiler::GetTime(), m_Depth);
+			Profiler::s_Depth--;
+		}
+
+		ProfileScope(const ProfileScope&) = delete;
+		ProfileScope& operator=(const ProfileScope&) = delete;
+	private:
+		const char* m_Name = nullptr;
+		uint64_t m_Start = 0;
+		uint32_t m_Depth = 0;
+	};
+
+}
+
+#if WL_ENABLE_PROFILING
+	#define WL_PROFILE_CONCAT_INTERNAL(a, b) a##b
+	#define WL_PROFILE_CONCAT(a, b) WL_PROFILE_CONCAT_INTERNAL(a, b)
+
+	#define WL_PROFILE_SCOPE(name) ::Walnut::ProfileScope WL_PROFILE_CONCAT(wlProfileScope, __LINE__)(name)
+	#define WL_PROFILE_FUNC() WL_PROFILE_SCOPE(__func__)
+	#define WL_PROFILE_FRAME() ::Walnut::Profiler::MarkFrame()
+	#define WL_PROFILE_THREAD(name) ::Walnut::Profiler::SetThreadName(name)
+#else
+	#define WL_PROFILE_SCOPE(name)
+	#define WL_PROFILE_FUNC()
+	#define WL_PROFILE_FRAME()
+	#define WL_PROFILE_THREAD(name)
+#endif
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "MappedRingBuffer.h"
+
+#include "spdlog/sinks/base_sink.h"
+#include "spdlog/details/null_mutex.h"
+
+#include <mutex>
+
+namespace Walnut {
+
+	//
+	// spdlog sink writing formatted lines into a crash-safe MappedRingBuffer.
+	// Disk use is capped at the ring capacity and there is no fsync per line;
+	// read it back with MappedRingBuffer::ReadRecords or Walnut-LogDecoder.
+	//
+	template<typename Mutex>
+	class RingBufferLogSink final : public spdlog::sinks::base_sink<Mutex>
+	{
+	public:
+		RingBufferLogSink(const std::filesystem::path& filepath, uint64_t capacity)
+			: m_RingBuffer(filepath, capacity)
+		{
+		}
+
+		bool IsValid() const { return m_RingBuffer.IsValid(); }
+	protected:
+		void sink_it_(const spdlog::details::log_msg& msg) override
+		{
+			spdlog::memory_buf_t formatted;
+			spdlog::sinks::base_sink<Mutex>::formatter_->format(msg, formatted);
+
+			// Records are lines, the end-of-line is added back when reading
+			size_t size = formatted.size();
+			while (size > 0 && (formatted[size - 1] == '\n' || formatted[size - 1] == '\r'))
+				size--;
+
+			m_RingBuffer.Write(formatted.data(), (uint32_t)size);
+		}
+
+		void flush_() override
+		{
+			m_RingBuffer.Flush();
+		}
+	private:
+		MappedRingBuffer m_RingBuffer;
+	};
+
+	using RingBufferLogSink_mt = RingBufferLogSink<std::mutex>;
+	using RingBufferLogSink_st = RingBufferLogSink<spdlog::details::null_mutex>;
+
+}
@@ -7,6 +7,8 @@ namespace Walnut {
 
 	int Main(int argc, char** argv)
 	{
+		// Only Application::Restart keeps g_ApplicationRunning set, the next application
+		// then takes over the window, device and loggers of the last one (soft restart)
 		while (g_ApplicationRunning)
 		{
 			Walnut::Application* app = Walnut::CreateApplication(argc, argv);
@@ -1,8 +1,139 @@
 #include "Random.h"
 
+#include <atomic>
+#include <random>
+
 namespace Walnut {
 
-	std::mt19937 Random::s_RandomEngine;
-	std::uniform_int_distribution<std::mt19937::result_type> Random::s_Distribution;
+	namespace {
+
+		constexpr uint64_t s_DefaultSeed = 0x853c49e6748fea9bull;
+		constexpr uint32_t s_LaneCount = 8;
+
+		// xoshiro128** lanes, stored by component so every step is one vector operation per lane set
+		struct BatchState
+		{
+			alignas(32) uint32_t S0[s_LaneCount];
+			alignas(32) uint32_t S1[s_LaneCount];
+			alignas(32) uint32_t S2[s_LaneCount];
+			alignas(32) uint32_t S3[s_LaneCount];
+			bool Seeded = false;
+		};
+
+		inline uint32_t RotateLeft(uint32_t x, int k)
+		{
+			return (x << k) | (x >> (32 - k));
+		}
+
+		inline void NextBatch(BatchState& batch, uint32_t* out)
+		{
+			for (uint32_t i = 0; i < s_LaneCount; i++)
+			{
+				out[i] = RotateLeft(batch.S1[i] * 5, 7) * 9;
+
+				const uint32_t t = batch.S1[i] << 9;
+				batch.S2[i] ^= batch.S0[i];
+				batch.S3[i] ^= batch.S1[i];
+				batch.S1[i] ^= batch.S2[i];
+				batch.S0[i] ^= batch.S3[i];
+				batch.S2[i] ^= t;
+				batch.S3[i] = RotateLeft(batch.S3[i], 11);
+			}
+		}
+
+	}
+
+	static std::atomic<uint64_t> s_Seed = s_DefaultSeed;
+	static std::atomic<uint64_t> s_NextStream = 0;
+	static thread_local BatchState s_Batch;
+
+	static BatchState& GetBatchState()
+	{
+		if (!s_Batch.Seeded)
+		{
+			for (uint32_t i = 0; i < s_LaneCount; i++)
+			{
+				s_Batch.S0[i] = Random::UInt();
+				s_Batch.S1[i] = Random::UInt();
+				s_Batch.S2[i] = Random::UInt();
+				// An all-zero state would only ever produce zeros
+				s_Batch.S3[i] = Random::UInt() | 1;
+			}
+			s_Batch.Seeded = true;
+		}
+		return s_Batch;
+	}
+
+	void Random::Init()
+	{
+		std::random_device device;
+		Init((uint64_t)device() << 32 | device());
+	}
+
+	void Random::Init(uint64_t seed)
+	{
+		s_Seed.store(seed, std::memory_order_relaxed);
+
+		State& state = GetState();
+		state.Seed(seed, state.Stream);
+		s_Batch.Seeded = false;
+	}
+
+	void Random::SetThreadStream(uint64_t stream)
+	{
+		GetState().Seed(s_Seed.load(std::memory_order_relaxed), stream);
+		s_Batch.Seeded = false;
+	}
+
+	Random::State Random::CreateThreadState()
+	{
+		State state;
+		state.Seed(s_Seed.load(std::memory_order_relaxed), s_NextStream.fetch_add(1, std::memory_order_relaxed));
+		return state;
+	}
+
+	void Random::Fill(std::span<uint32_t> values)
+	{
+		BatchState& batch = GetBatchState();
+
+		size_t i = 0;
+		for (; i + s_LaneCount <= values.size(); i += s_LaneCount)
+			NextBatch(batch, values.data() + i);
+
+		if (i < values.size())
+		{
+			uint32_t bits[s_LaneCount];
+			NextBatch(batch, bits);
+			for (size_t j = 0; i + j < values.size(); j++)
+				values[i + j] = bits[j];
+		}
+	}
+
+	void Random::Fill(std::span<float> values)
+	{
+		Fill(values, 0.0f, 1.0f);
+	}
+
+	void Random::Fill(std::span<float> values, float min, float max)
+	{
+		BatchState& batch = GetBatchState();
+		const float scale = (max - min) * 0x1.0p-24f;
+
+		uint32_t bits[s_LaneCount];
+		for (size_t i = 0; i < values.size(); i += s_LaneCount)
+		{
+			NextBatch(batch, bits);
+
+			const size_t count = values.size() - i < s_LaneCount ? values.size() - i : s_LaneCount;
+			for (size_t j = 0; j < count; j++)
+				values[i + j] = (float)(bits[j] >> 8) * scale + min;
+		}
+	}
+
+	void Random::Fill(std::span<glm::vec3> values, float min, float max)
+	{
+		static_assert(sizeof(glm::vec3) == sizeof(float) * 3, "glm::vec3 has to be tightly packed");
+		Fill(std::span<float>((float*)values.data(), values.size() * 3), min, max);
+	}
 
-}
\ No newline at end of file
+}
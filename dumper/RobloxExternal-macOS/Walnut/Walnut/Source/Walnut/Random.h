@@ -1,32 +1,68 @@
 #pragma once
 
-#include <random>
+#include <cstdint>
+#include <span>
 
 #include <glm/glm.hpp>
 
 namespace Walnut {
 
+	//
+	// Thread-local PCG32 generator (https://www.pcg-random.org), threads never share state.
+	// Each thread draws from its own stream of the global seed. Streams are handed out in the order
+	// threads first use Random, SetThreadStream pins one for results that must not depend on scheduling.
+	// Ranges are unbiased (Lemire's multiply-shift with rejection).
+	//
+	// The Fill functions generate in bulk from eight interleaved xoshiro128** lanes written so the
+	// compiler vectorizes them, seeded from the thread's generator; their sequence differs from the scalar one.
+	//
 	class Random
 	{
 	public:
-		static void Init()
-		{
-			s_RandomEngine.seed(std::random_device()());
-		}
+		// Seeds from std::random_device, without it the seed is fixed
+		static void Init();
+		// Threads that haven't used Random yet pick up the new seed, the calling thread is reseeded
+		static void Init(uint64_t seed);
+
+		// Reseeds the calling thread with the given stream of the global seed
+		static void SetThreadStream(uint64_t stream);
 
 		static uint32_t UInt()
 		{
-			return s_Distribution(s_RandomEngine);
+			return GetState().Next();
 		}
 
+		// [min, max]
 		static uint32_t UInt(uint32_t min, uint32_t max)
 		{
-			return min + (s_Distribution(s_RandomEngine) % (max - min + 1));
+			const uint32_t range = max - min + 1;
+			if (range == 0)
+				return UInt();
+
+			State& state = GetState();
+			uint64_t m = (uint64_t)state.Next() * range;
+			uint32_t low = (uint32_t)m;
+			if (low < range)
+			{
+				const uint32_t threshold = (0u - range) % range;
+				while (low < threshold)
+				{
+					m = (uint64_t)state.Next() * range;
+					low = (uint32_t)m;
+				}
+			}
+			return min + (uint32_t)(m >> 32);
 		}
 
+		// [0, 1)
 		static float Float()
 		{
-			return (float)s_Distribution(s_RandomEngine) / (float)std::numeric_limits<uint32_t>::max();
+			return (float)(UInt() >> 8) * 0x1.0p-24f;
+		}
+
+		static float Float(float min, float max)
+		{
+			return Float() * (max - min) + min;
 		}
 
 		static glm::vec3 Vec3()
@@ -36,18 +72,54 @@ namespace Walnut {
 
 		static glm::vec3 Vec3(float min, float max)
 		{
-			return glm::vec3(Float() * (max - min) + min, Float() * (max - min) + min, Float() * (max - min) + min);
+			return glm::vec3(Float(min, max), Float(min, max), Float(min, max));
 		}
 
 		static glm::vec3 InUnitSphere()
 		{
 			return glm::normalize(Vec3(-1.0f, 1.0f));
 		}
+
+		// Bulk generation
+		static void Fill(std::span<uint32_t> values);
+		// [0, 1)
+		static void Fill(std::span<float> values);
+		static void Fill(std::span<float> values, float min, float max);
+		static void Fill(std::span<glm::vec3> values, float min = 0.0f, float max = 1.0f);
 	private:
-		static std::mt19937 s_RandomEngine;
-		static std::uniform_int_distribution<std::mt19937::result_type> s_Distribution;
-	};
+		struct State
+		{
+			uint64_t Value = 0;
+			uint64_t Increment = 1;
+			uint64_t Stream = 0;
 
-}
+			void Seed(uint64_t seed, uint64_t stream)
+			{
+				Stream = stream;
+				Value = 0;
+				Increment = (stream << 1) | 1;
+				Next();
+				Value += seed;
+				Next();
+			}
+
+			uint32_t Next()
+			{
+				const uint64_t old = Value;
+				Value = old * 6364136223846793005ull + Increment;
+				const uint32_t xorshifted = (uint32_t)(((old >> 18) ^ old) >> 27);
+				const uint32_t rotation = (uint32_t)(old >> 59);
+				return (xorshifted >> rotation) | (xorshifted << ((0u - rotation) & 31));
+			}
+		};
+
+		static State CreateThreadState();
 
+		static State& GetState()
+		{
+			thread_local State state = CreateThreadState();
+			return state;
+		}
+	};
 
+}
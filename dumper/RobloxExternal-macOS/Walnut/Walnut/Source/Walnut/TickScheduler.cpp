@@ -0,0 +1,97 @@
+#include "TickScheduler.h"
+
+#include <thread>
+
+namespace Walnut {
+
+	void TickScheduler::SetRate(double ticksPerSecond)
+	{
+		if (ticksPerSecond <= 0.0)
+			return;
+
+		m_Period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / ticksPerSecond));
+	}
+
+	void TickScheduler::Start()
+	{
+		m_NextTick = Clock::now();
+		m_CatchUpTicks = 0;
+		m_TickCount = 0;
+		m_OverrunCount = 0;
+	}
+
+	bool TickScheduler::WaitForNextTick()
+	{
+		ApplyOverrunPolicy();
+
+		// Sleep through most of the wait, the condition variable lets Wake() cut it short
+		{
+			std::unique_lock<std::mutex> lock(m_WakeMutex);
+			const Clock::time_point sleepUntil = m_NextTick - m_SpinDuration;
+			if (Clock::now() < sleepUntil)
+				m_WakeCondition.wait_until(lock, sleepUntil, [this]() { return m_WakeRequested; });
+
+			if (m_WakeRequested)
+			{
+				m_WakeRequested = false;
+				return false;
+			}
+		}
+
+		// Spin for the last stretch, sleep wake-ups are too coarse for this part
+		while (Clock::now() < m_NextTick)
+			std::this_thread::yield();
+
+		m_TickCount++;
+		m_NextTick += m_Period;
+		return true;
+	}
+
+	void TickScheduler::Wake()
+	{
+		{
+			std::scoped_lock<std::mutex> lock(m_WakeMutex);
+			m_WakeRequested = true;
+		}
+		m_WakeCondition.notify_one();
+	}
+
+	void TickScheduler::ApplyOverrunPolicy()
+	{
+		const Clock::time_point now = Clock::now();
+		if (now <= m_NextTick)
+		{
+			m_CatchUpTicks = 0;
+			return;
+		}
+
+		// The last update ran past the deadline of this tick
+		m_OverrunCount++;
+
+		switch (m_OverrunPolicy)
+		{
+			case TickOverrunPolicy::CatchUp:
+			{
+				if (++m_CatchUpTicks <= m_MaxCatchUpTicks)
+					return;
+
+				// Too far behind, give up on the backlog
+				m_CatchUpTicks = 0;
+				m_NextTick = now;
+				break;
+			}
+			case TickOverrunPolicy::Skip:
+			{
+				const auto missedTicks = (now - m_NextTick) / m_Period;
+				m_NextTick += m_Period * (missedTicks + 1);
+				break;
+			}
+			case TickOverrunPolicy::Reset:
+			{
+				m_NextTick = now;
+				break;
+			}
+		}
+	}
+
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+namespace Walnut {
+
+	enum class TickOverrunPolicy
+	{
+		// Run the missed ticks back-to-back (up to MaxCatchUpTicks), then realign
+		CatchUp = 0,
+		// Drop the missed ticks and stay aligned to the original tick grid
+		Skip,
+		// Start a fresh period from the end of the late tick
+		Reset
+	};
+
+	//
+	// Drift-free fixed-rate ticking
+	//
+	// Deadlines are derived from the tick grid instead of "now + period", so the
+	// cost of an update doesn't accumulate into the rate. Waiting sleeps until shortly
+	// before the deadline and spins for the last stretch to absorb OS timer slack.
+	// Wake() ends a wait early, eg. when the application closes or work gets queued.
+	//
+	class TickScheduler
+	{
+	public:
+		using Clock = std::chrono::steady_clock;
+	public:
+		TickScheduler() = default;
+
+		void SetPeriod(Clock::duration period) { m_Period = period; }
+		void SetRate(double ticksPerSecond);
+		void SetOverrunPolicy(TickOverrunPolicy policy) { m_OverrunPolicy = policy; }
+		void SetMaxCatchUpTicks(uint32_t maxTicks) { m_MaxCatchUpTicks = maxTicks; }
+		void SetSpinDuration(Clock::duration duration) { m_SpinDuration = duration; }
+
+		Clock::duration GetPeriod() const { return m_Period; }
+		uint64_t GetTickCount() const { return m_TickCount; }
+		uint64_t GetOverrunCount() const { return m_OverrunCount; }
+
+		// The first tick is due immediately
+		void Start();
+
+		// Blocks until the next tick is due and returns true, or returns false if Wake() was called first
+		bool WaitForNextTick();
+
+		// Thread-safe
+		void Wake();
+	private:
+		void ApplyOverrunPolicy();
+	private:
+		Clock::duration m_Period = std::chrono::milliseconds(16);
+		Clock::duration m_SpinDuration = std::chrono::milliseconds(1);
+		TickOverrunPolicy m_OverrunPolicy = TickOverrunPolicy::Skip;
+		uint32_t m_MaxCatchUpTicks = 5;
+
+		Clock::time_point m_NextTick;
+		uint32_t m_CatchUpTicks = 0;
+		uint64_t m_TickCount = 0;
+		uint64_t m_OverrunCount = 0;
+
+		std::mutex m_WakeMutex;
+		std::condition_variable m_WakeCondition;
+		bool m_WakeRequested = false;
+	};
+
+}
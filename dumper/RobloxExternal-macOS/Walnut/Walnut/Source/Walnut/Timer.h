@@ -3,9 +3,31 @@
 #include <iostream>
 #include <string>
 #include <chrono>
+#include <cstdint>
 
 namespace Walnut {
 
+	//
+	// Monotonic clock with integer nanosecond ticks.
+	// int64 nanoseconds cover ~292 years without losing resolution, unlike float
+	// seconds which quantize to milliseconds after a few days, so keep time points
+	// and long spans in Clock ticks and only convert differences to floating point.
+	//
+	class Clock
+	{
+	public:
+		// Nanoseconds since an arbitrary fixed point
+		static int64_t Now()
+		{
+			return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+		}
+
+		static constexpr double ToSeconds(int64_t nanoseconds) { return (double)nanoseconds * 1e-9; }
+		static constexpr double ToMilliseconds(int64_t nanoseconds) { return (double)nanoseconds * 1e-6; }
+		static constexpr int64_t FromSeconds(double seconds) { return (int64_t)(seconds * 1e9); }
+		static constexpr int64_t FromMilliseconds(double milliseconds) { return (int64_t)(milliseconds * 1e6); }
+	};
+
 	class Timer
 	{
 	public:
@@ -16,21 +38,32 @@ namespace Walnut {
 
 		void Reset()
 		{
-			m_Start = std::chrono::high_resolution_clock::now();
+			m_Start = Clock::Now();
+		}
+
+		int64_t ElapsedNanoseconds() const
+		{
+			return Clock::Now() - m_Start;
+		}
+
+		double ElapsedSeconds() const
+		{
+			return Clock::ToSeconds(ElapsedNanoseconds());
 		}
 
-		float Elapsed()
+		// Single precision seconds, fine for short spans only
+		float Elapsed() const
 		{
-			return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - m_Start).count() * 0.001f * 0.001f * 0.001f;
+			return (float)ElapsedSeconds();
 		}
 
-		float ElapsedMillis()
+		float ElapsedMillis() const
 		{
-			return Elapsed() * 1000.0f;
+			return (float)Clock::ToMilliseconds(ElapsedNanoseconds());
 		}
 
 	private:
-		std::chrono::time_point<std::chrono::high_resolution_clock> m_Start;
+		int64_t m_Start = 0;
 	};
 
 	class ScopedTimer
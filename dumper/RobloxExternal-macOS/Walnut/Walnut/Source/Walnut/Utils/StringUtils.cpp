@@ -1,32 +1,107 @@
 #include "StringUtils.h"
 
+#include <bit>
+#include <cstring>
+
 namespace Walnut::Utils {
 
-	std::vector<std::string> SplitString(const std::string_view string, const std::string_view& delimiters)
+	namespace {
+
+		constexpr uint64_t s_LowBits = 0x0101010101010101ull;
+		constexpr uint64_t s_HighBits = 0x8080808080808080ull;
+
+		// High bit set in every byte of v that is zero, exact for the lowest one
+		inline uint64_t ZeroBytes(uint64_t v)
+		{
+			return (v - s_LowBits) & ~v & s_HighBits;
+		}
+
+	}
+
+	DelimiterSet::DelimiterSet(char delimiter)
 	{
-		size_t first = 0;
+		m_Table[(uint8_t)delimiter] = true;
+		m_Delimiters[0] = delimiter;
+		m_Count = 1;
+	}
 
-		std::vector<std::string> result;
+	DelimiterSet::DelimiterSet(std::string_view delimiters)
+	{
+		for (char c : delimiters)
+		{
+			if (m_Table[(uint8_t)c])
+				continue;
+
+			m_Table[(uint8_t)c] = true;
+			if (m_Count < s_MaxSWARDelimiters)
+				m_Delimiters[m_Count] = c;
+			m_Count++;
+		}
+	}
+
+	size_t DelimiterSet::Find(std::string_view string, size_t offset) const
+	{
+		if (offset >= string.size() || m_Count == 0)
+			return std::string_view::npos;
+
+		const char* data = string.data();
+		const size_t size = string.size();
+
+		if (m_Count == 1)
+		{
+			const void* found = memchr(data + offset, m_Delimiters[0], size - offset);
+			return found ? (size_t)((const char*)found - data) : std::string_view::npos;
+		}
 
-		while (first <= string.size())
+		size_t i = offset;
+		if constexpr (std::endian::native == std::endian::little)
 		{
-			const auto second = string.find_first_of(delimiters, first);
+			if (m_Count <= s_MaxSWARDelimiters)
+			{
+				uint64_t patterns[s_MaxSWARDelimiters];
+				for (uint32_t d = 0; d < s_MaxSWARDelimiters; d++)
+					patterns[d] = s_LowBits * (uint8_t)m_Delimiters[d < m_Count ? d : 0];
 
-			if (first != second)
-				result.emplace_back(string.substr(first, second - first));
+				for (; i + 8 <= size; i += 8)
+				{
+					uint64_t word;
+					memcpy(&word, data + i, 8);
 
-			if (second == std::string_view::npos)
-				break;
+					uint64_t matches = 0;
+					for (uint32_t d = 0; d < s_MaxSWARDelimiters; d++)
+						matches |= ZeroBytes(word ^ patterns[d]);
 
-			first = second + 1;
+					if (matches)
+						return i + (size_t)(std::countr_zero(matches) / 8);
+				}
+			}
 		}
 
+		for (; i < size; i++)
+		{
+			if (m_Table[(uint8_t)data[i]])
+				return i;
+		}
+
+		return std::string_view::npos;
+	}
+
+	std::vector<std::string> SplitString(const std::string_view string, const std::string_view& delimiters)
+	{
+		std::vector<std::string> result;
+		for (std::string_view token : Split(string, delimiters))
+			result.emplace_back(token);
+
 		return result;
 	}
 
 	std::vector<std::string> SplitString(const std::string_view string, const char delimiter)
 	{
-		return SplitString(string, std::string(1, delimiter));
+		std::vector<std::string> result;
+		for (std::string_view token : Split(string, delimiter))
+			result.emplace_back(token);
+
+		return result;
 	}
 
-}
\ No newline at end of file
+}
@@ -1,11 +1,112 @@
 #pragma once
 
+#include <array>
+#include <cstdint>
+#include <iterator>
 #include <string>
 #include <string_view>
 #include <vector>
 
 namespace Walnut::Utils {
 
+	// Set of single-character delimiters with a fast search: memchr for one character,
+	// eight bytes at a time (SWAR) for up to four, a lookup table beyond that
+	class DelimiterSet
+	{
+	public:
+		DelimiterSet(char delimiter);
+		DelimiterSet(std::string_view delimiters);
+
+		// Position of the first delimiter at or after offset, npos if there is none
+		size_t Find(std::string_view string, size_t offset = 0) const;
+
+		bool Contains(char c) const { return m_Table[(uint8_t)c]; }
+	private:
+		static constexpr size_t s_MaxSWARDelimiters = 4;
+
+		std::array<bool, 256> m_Table = {};
+		std::array<char, s_MaxSWARDelimiters> m_Delimiters = {};
+		uint32_t m_Count = 0;
+	};
+
+	//
+	// Lazy split into std::string_views of the original string, nothing is allocated.
+	// Empty tokens (consecutive delimiters, leading or trailing ones) are skipped.
+	//   for (std::string_view token : Utils::Split(command, ' '))
+	//
+	class StringSplitter
+	{
+	public:
+		class Iterator
+		{
+		public:
+			using iterator_concept = std::forward_iterator_tag;
+			using iterator_category = std::forward_iterator_tag;
+			using value_type = std::string_view;
+			using difference_type = std::ptrdiff_t;
+
+			Iterator() = default;
+			Iterator(const StringSplitter* splitter, size_t offset)
+				: m_Splitter(splitter), m_Offset(offset)
+			{
+				Advance();
+			}
+
+			std::string_view operator*() const { return m_Token; }
+			const std::string_view* operator->() const { return &m_Token; }
+
+			Iterator& operator++() { Advance(); return *this; }
+			Iterator operator++(int) { Iterator it = *this; Advance(); return it; }
+
+			bool operator==(const Iterator& other) const { return m_Token.data() == other.m_Token.data() && m_Done == other.m_Done; }
+			bool operator==(std::default_sentinel_t) const { return m_Done; }
+		private:
+			void Advance()
+			{
+				const std::string_view string = m_Splitter->m_String;
+				while (m_Offset < string.size())
+				{
+					size_t end = m_Splitter->m_Delimiters.Find(string, m_Offset);
+					if (end == std::string_view::npos)
+						end = string.size();
+
+					const size_t begin = m_Offset;
+					m_Offset = end + 1;
+					if (end != begin)
+					{
+						m_Token = string.substr(begin, end - begin);
+						m_Done = false;
+						return;
+					}
+				}
+
+				m_Token = {};
+				m_Done = true;
+			}
+		private:
+			const StringSplitter* m_Splitter = nullptr;
+			size_t m_Offset = 0;
+			std::string_view m_Token;
+			bool m_Done = true;
+		};
+
+		StringSplitter(std::string_view string, DelimiterSet delimiters)
+			: m_String(string), m_Delimiters(delimiters)
+		{
+		}
+
+		Iterator begin() const { return Iterator(this, 0); }
+		std::default_sentinel_t end() const { return {}; }
+	private:
+		std::string_view m_String;
+		DelimiterSet m_Delimiters;
+	};
+
+	// The string has to outlive the tokens, and the splitter its iterators
+	inline StringSplitter Split(std::string_view string, char delimiter) { return StringSplitter(string, DelimiterSet(delimiter)); }
+	inline StringSplitter Split(std::string_view string, std::string_view delimiters) { return StringSplitter(string, DelimiterSet(delimiters)); }
+
+	// Allocating versions, prefer Split on hot paths
 	std::vector<std::string> SplitString(const std::string_view string, const std::string_view& delimiters);
 	std::vector<std::string> SplitString(const std::string_view string, const char delimiter);
 
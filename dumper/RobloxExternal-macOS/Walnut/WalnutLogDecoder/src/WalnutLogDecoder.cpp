@@ -0,0 +1,69 @@
+//
+// Walnut-LogDecoder
+// Turns binary logs written by Walnut::Log::InitBinaryLog back into text or JSON lines,
+// and prints the recent history kept in a log ring buffer (WALNUT.ring) in order.
+//
+// Usage: Walnut-LogDecoder [--json] <file.wlog | file.ring>
+//
+
+#include "Walnut/Core/BinaryLog.h"
+#include "Walnut/Core/MappedRingBuffer.h"
+
+#include <iostream>
+#include <string_view>
+
+int main(int argc, char** argv)
+{
+	bool json = false;
+	const char* filepath = nullptr;
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string_view arg = argv[i];
+		if (arg == "--json")
+			json = true;
+		else
+			filepath = argv[i];
+	}
+
+	if (!filepath)
+	{
+		std::cerr << "Usage: " << argv[0] << " [--json] <file.wlog | file.ring>\n";
+		return 1;
+	}
+
+	if (Walnut::MappedRingBuffer::IsRingBufferFile(filepath))
+	{
+		for (const std::string& line : Walnut::MappedRingBuffer::ReadRecords(filepath))
+			std::cout << line << '\n';
+
+		return 0;
+	}
+
+	Walnut::BinaryLogReader reader(filepath);
+	if (!reader.IsValid())
+	{
+		std::cerr << "Not a Walnut binary log: " << filepath << "\n";
+		return 1;
+	}
+
+	Walnut::BinaryLogReader::Entry entry;
+	while (reader.ReadNext(entry))
+	{
+		if (json)
+		{
+			std::cout << Walnut::BinaryLogReader::ToJSON(entry) << '\n';
+		}
+		else
+		{
+			// Matches the "[%T] [%l] %n: %v" pattern of the text file sinks
+			std::cout << '[' << Walnut::BinaryLogReader::FormatTimestamp(entry.Timestamp) << "] "
+				<< '[' << Walnut::BinaryLogReader::LevelToString(entry.Format->Level) << "] "
+				<< (entry.Format->LoggerType == 0 ? "WALNUT" : "APP") << ": "
+				<< '[' << entry.Format->Tag << "] " << Walnut::BinaryLogReader::FormatMessage(entry)
+				<< " (thread " << entry.ThreadID << ")\n";
+		}
+	}
+
+	return 0;
+}